@@ -0,0 +1,225 @@
+/**
+ * Arena.h
+ *
+ * Abstract:
+ * A bump allocator for request-scoped object graphs.  Objects are carved
+ * out of large chunks with pointer arithmetic - no per-object bookkeeping -
+ * and the whole region is released at once when the arena is reset or
+ * destroyed.  For a request that builds thousands of small objects and
+ * throws them all away together, this replaces thousands of frees with one
+ * pointer reset.
+ *
+ * Pairs with UP's NoDelete deleter (see UP.h): Arena::MakeUP hands back a
+ * UP< TYPE, NoDelete > that keeps the usual owning-pointer semantics in the
+ * code without ever issuing an individual delete.
+ *
+ * @see UP.h MemCache.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "UP.h"
+
+/**
+ * The Working Bits Systems namespace
+ */
+namespace wbs
+{
+    /**
+     * @class Arena
+     * A region allocator: Allocate/Make bump a cursor through the current
+     * chunk, growing by whole chunks as needed; Reset releases everything
+     * in one motion.  An arena is meant to be owned by one request (or one
+     * thread) - it does no locking.
+     *
+     * @note Object DESTRUCTORS ARE NOT RUN by Reset or by the arena's own
+     *       destructor; only the memory is released.  Arena objects should
+     *       be trivially destructible, or their cleanup must not matter
+     *       (no owned heap memory, handles, or locks).
+     */
+    class Arena
+    {
+    public:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Constructs an empty arena.  No memory is allocated until the
+         * first request.
+         *
+         * @param chunkSize - the size of each chunk the arena grows by.
+         *                    Allocations larger than this get a dedicated
+         *                    chunk of their own size.
+         */
+        explicit Arena( std::size_t chunkSize = DEFAULT_CHUNK_SIZE )
+        {
+            m_chunks = nullptr;
+            m_cursor = nullptr;
+            m_end = nullptr;
+            m_chunkSize = chunkSize;
+        }
+
+        /**
+         * The Destructor.  Releases every chunk; no object destructors are
+         * run (see the class note).
+         */
+        ~Arena()
+        {
+            FreeChunks( nullptr );
+        }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Allocates raw storage from the arena.
+         *
+         * @param size      - the number of bytes needed.
+         * @param alignment - the required alignment; defaults to the
+         *                    strictest fundamental alignment.
+         *
+         * @return A pointer to the storage.  Valid until Reset() or the
+         *         arena's destruction.
+         */
+        void* Allocate( std::size_t size,
+                        std::size_t alignment = alignof( std::max_align_t ) )
+        {
+            char* aligned = AlignUp( m_cursor, alignment );
+            if ( ( nullptr == m_cursor ) ||
+                 ( static_cast< std::size_t >( m_end - aligned ) < size ) )
+            {
+                Grow( size + alignment );
+                aligned = AlignUp( m_cursor, alignment );
+            }
+
+            m_cursor = aligned + size;
+
+            return aligned;
+        }
+
+        /**
+         * Constructs an object in the arena, forwarding the passed
+         * arguments to its constructor.
+         *
+         * @param args - the arguments to forward to TYPE's constructor.
+         *
+         * @return A pointer to the constructed object.  Do NOT delete it;
+         *         its storage belongs to the arena.
+         */
+        template< typename TYPE, typename... ARGS >
+        TYPE* Make( ARGS&&... args )
+        {
+            return ::new ( Allocate( sizeof( TYPE ), alignof( TYPE ) ) )
+                TYPE( std::forward< ARGS >( args )... );
+        }
+
+        /**
+         * Constructs an object in the arena and wraps it in a UP with the
+         * NoDelete deleter, so the code keeps its owning-pointer semantics
+         * while the storage stays arena-owned.
+         *
+         * @param args - the arguments to forward to TYPE's constructor.
+         *
+         * @return A UP< TYPE, NoDelete > referencing the arena object.
+         */
+        template< typename TYPE, typename... ARGS >
+        UP< TYPE, NoDelete > MakeUP( ARGS&&... args )
+        {
+            return UP< TYPE, NoDelete >(
+                Make< TYPE >( std::forward< ARGS >( args )... ) );
+        }
+
+        /**
+         * Releases the arena's memory in one motion, keeping the current
+         * chunk for reuse so a steady-state request loop stops allocating
+         * altogether.  Every pointer previously handed out becomes invalid.
+         */
+        void Reset()
+        {
+            if ( nullptr != m_chunks )
+            {
+                FreeChunks( m_chunks );
+                m_cursor = reinterpret_cast< char* >( m_chunks + 1 );
+                m_end = m_cursor + m_chunks->m_size;
+            }
+        }
+
+    private:
+        // Constructors, destructor, and Assignment operator -------------------
+        // An arena owns its region outright; copying one is meaningless.
+        Arena( const Arena& );
+        const Arena& operator=( const Arena& );
+
+        // Constants -----------------------------------------------------------
+        // The default growth unit.  Big enough that chunk overhead
+        // vanishes for graphs of small objects, small enough not to sting
+        // for short-lived arenas.
+        static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+        // Attributes ----------------------------------------------------------
+        // The header preceding each chunk's storage; chunks form a LIFO
+        // list with the current (newest) chunk at the head.
+        struct Chunk
+        {
+            Chunk*      m_next;
+            std::size_t m_size;
+        };
+
+        // Rounds a pointer up to the requested alignment.
+        static char* AlignUp( char* p, std::size_t alignment )
+        {
+            return reinterpret_cast< char* >(
+                ( reinterpret_cast< std::uintptr_t >( p ) + alignment - 1 )
+                & ~( static_cast< std::uintptr_t >( alignment ) - 1 ) );
+        }
+
+        // Adds a chunk big enough for at least the requested bytes and
+        // points the cursor into it.
+        void Grow( std::size_t minimum )
+        {
+            std::size_t bytes =
+                ( minimum > m_chunkSize ) ? minimum : m_chunkSize;
+
+            Chunk* chunk = static_cast< Chunk* >(
+                ::operator new( sizeof( Chunk ) + bytes ) );
+            chunk->m_next = m_chunks;
+            chunk->m_size = bytes;
+            m_chunks = chunk;
+
+            m_cursor = reinterpret_cast< char* >( chunk + 1 );
+            m_end = m_cursor + bytes;
+        }
+
+        // Frees every chunk except the passed one (null frees them all).
+        void FreeChunks( Chunk* keep )
+        {
+            Chunk* chunk = m_chunks;
+            while ( nullptr != chunk )
+            {
+                Chunk* next = chunk->m_next;
+                if ( chunk != keep )
+                {
+                    ::operator delete( chunk );
+                }
+                chunk = next;
+            }
+
+            m_chunks = keep;
+            if ( nullptr != keep )
+            {
+                keep->m_next = nullptr;
+            }
+        }
+
+        // The chunk list and the bump window into the head chunk.
+        Chunk*      m_chunks;
+        char*       m_cursor;
+        char*       m_end;
+        std::size_t m_chunkSize;
+    };
+}; // End of namespace wbs
+
+#endif // #ifndef _ARENA_H_
@@ -0,0 +1,301 @@
+/**
+ * CowP.h
+ *
+ * Abstract:
+ * Definition of a copy-on-write pointer layered on SP.  A CowP hands out
+ * shared READ access to an object for the price of a reference-count bump,
+ * and clones the object only when someone actually writes to it while
+ * others are still reading.  It exists for the read-mostly shared objects
+ * (configuration, routing tables, and the like) that would otherwise be
+ * deep-copied defensively on every hand-out: with a CowP the thousands of
+ * reads cost nothing, and the rare writer pays the one copy that matters.
+ *
+ * Reads go through the const accessors (operator->, operator*, Read),
+ * which never clone.  Writes go through Mutate(), which checks the strong
+ * count: if this CowP is the sole owner the object is returned as-is, and
+ * otherwise a clone is made (via the object's copy constructor, through
+ * MakeSP so the clone is a single allocation) and this CowP re-points to
+ * it, leaving the other readers on the old version undisturbed.
+ *
+ * A CowP instance is no more thread-safe than an SP instance: share an
+ * object across threads by giving each thread its own CowP copy, and
+ * serialize writers among themselves.  A reader's copy pins the version it
+ * was copied from, so a concurrent Mutate elsewhere never changes an
+ * object mid-read.
+ *
+ * @see SP.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _COWP_H_
+#define _COWP_H_
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include "SP.h"
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    // Forward declare the pointer class so the factory can name it.
+    template< typename TYPECOW, typename POLICY > class CowP;
+
+    // Forward declare the factory so it can be made a friend below.  See
+    // the definition at the bottom of this file.
+    template < typename TYPECOW, typename POLICY = MultiThreaded,
+               typename... ARGS >
+    CowP< TYPECOW, POLICY > MakeCowP( ARGS&&... args );
+
+    /**
+     * @class CowP
+     *
+     * A copy-on-write pointer: shared reads through const access, with the
+     * object cloned on write only while it is actually shared (see the file
+     * header).  The TYPECOW must be copy-constructible - that copy IS the
+     * "write" half of copy-on-write - and Mutate enforces this at compile
+     * time.
+     *
+     * The POLICY parameter matches SP's threading policies.  The
+     * BiasedThreaded policy is excluded: its strong count is a liveness
+     * stub rather than an exact count (see ControlBlock::StrongCount), so
+     * the sole-owner test Mutate depends on cannot be answered under it.
+     */
+    template< typename TYPECOW, typename POLICY = MultiThreaded > class CowP
+    {
+    public:
+        static_assert( !std::is_same_v< POLICY, BiasedThreaded >,
+                       "CowP needs an exact strong count to detect sole "
+                       "ownership, which the BiasedThreaded policy does "
+                       "not provide." );
+
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Default constructor; the null CowP.
+         */
+        CowP()
+        {
+        }
+
+        /**
+         * A constructor from a c-style raw pointer.  This takes ownership
+         * from the passed raw pointer; prefer MakeCowP, which builds the
+         * object and its count block in one allocation.
+         *
+         * @param p - The c-style raw pointer whose object will be managed
+         *            by this CowP.
+         */
+        CowP( TYPECOW* p )
+        : m_ptr( p )
+        {
+        }
+
+        /**
+         * The copy constructor.  This is the cheap hand-out: the new CowP
+         * shares the current version of the object (a count bump, no
+         * copy), and pins that version against writers elsewhere.
+         *
+         * @param other - The other CowP to share the object with.
+         */
+        CowP( const CowP< TYPECOW, POLICY >& other )
+        : m_ptr( other.m_ptr )
+        {
+        }
+
+        /**
+         * The move semantics copy constructor.
+         *
+         * @param other - The other CowP to take the object from.
+         */
+        CowP( CowP< TYPECOW, POLICY >&& other )
+        : m_ptr( std::move( other.m_ptr ) )
+        {
+        }
+
+        /**
+         * The assignment operator.
+         *
+         * @param other - The other CowP to share the object with.
+         *
+         * @return The reference to this pointer.
+         */
+        CowP& operator=( const CowP< TYPECOW, POLICY >& other )
+        {
+            m_ptr = other.m_ptr;
+            return *this;
+        }
+
+        /**
+         * The move semantics assignment operator.
+         *
+         * @param other - The other CowP to take the object from.
+         *
+         * @return The reference to this pointer.
+         */
+        CowP& operator=( CowP< TYPECOW, POLICY >&& other )
+        {
+            m_ptr = std::move( other.m_ptr );
+            return *this;
+        }
+
+        // Operations ----------------------------------------------------------
+        /**
+         * The arrow operator - read access only, so it never clones.
+         *
+         * @return The const pointer to the current version of the object.
+         */
+        const TYPECOW* operator->() const
+        {
+            return m_ptr.UnsafeAccess();
+        }
+
+        /**
+         * The star operator - read access only, so it never clones.
+         *
+         * @return A const reference to the current version of the object.
+         *
+         * @note As with SP, dereferencing a null CowP is dereferencing a
+         *       null pointer.
+         */
+        const TYPECOW& operator*() const
+        {
+            return *m_ptr.UnsafeAccess();
+        }
+
+        /**
+         * Comparison operators.  Lumping these all together for ease.  Two
+         * CowPs compare equal while they share a version; a Mutate that
+         * clones makes them unequal, as it must.
+         *
+         * @param rhs - the right-hand-side of the comparison (this is lhs)
+         *
+         * @return true if this pointer has the relationship to the rhs as
+         *         specified.
+         */
+        inline bool operator==( const CowP< TYPECOW, POLICY >& other ) const { return Read() == other.Read(); }
+        inline bool operator!=( const CowP< TYPECOW, POLICY >& other ) const { return Read() != other.Read(); }
+        inline bool operator<( const CowP< TYPECOW, POLICY >& other ) const  { return Read() < other.Read(); }
+        inline bool operator<=( const CowP< TYPECOW, POLICY >& other ) const { return Read() <= other.Read(); }
+        inline bool operator>( const CowP< TYPECOW, POLICY >& other ) const  { return Read() > other.Read(); }
+        inline bool operator>=( const CowP< TYPECOW, POLICY >& other ) const { return Read() >= other.Read(); }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Read access to the current version of the object, alongside the
+         * const operators for when a named method reads better.
+         *
+         * @return The const pointer to the object, or nullptr if unset.
+         */
+        const TYPECOW* Read() const
+        {
+            return m_ptr.UnsafeAccess();
+        }
+
+        /**
+         * Write access to the object.  If this CowP is the sole owner the
+         * object is returned directly; otherwise the object is cloned (by
+         * its copy constructor) and this CowP re-points to the clone, so
+         * the write cannot be seen by anyone sharing the old version.
+         *
+         * @return The mutable pointer to this CowP's (possibly freshly
+         *         cloned) object, or nullptr if unset.
+         *
+         * @note Serialize writers to a shared object among themselves; two
+         *       threads calling Mutate through copies of the same CowP at
+         *       once each get their own clone, and last-writer-wins is the
+         *       best that can mean.
+         */
+        TYPECOW* Mutate()
+        {
+            static_assert( std::is_copy_constructible_v< TYPECOW >,
+                           "Copy-on-write requires a copy-constructible "
+                           "object; the copy is the write path." );
+
+            if ( 1 < m_ptr.UseCount() )
+            {
+                m_ptr = MakeSP< TYPECOW, POLICY >( *m_ptr.UnsafeAccess() );
+            }
+            else if constexpr ( !std::is_same_v< POLICY, SingleThreaded > )
+            {
+                // A count of 1 may have been produced the instant another
+                // thread released its copy.  That release is a
+                // memory_order_release decrement, so this acquire fence
+                // orders the releasing thread's last reads of the object
+                // before the in-place writes about to happen here.
+                std::atomic_thread_fence( std::memory_order_acquire );
+            }
+
+            return m_ptr.UnsafeAccess();
+        }
+
+        /**
+         * Releases this CowP's reference to the object (deleting the
+         * object if this was the last one) and nulls this CowP.
+         */
+        void Delete()
+        {
+            m_ptr.Delete();
+        }
+
+        /**
+         * Determined if this pointer is pointing to anything.
+         *
+         * @return true if the internal reference is null, false otherwise.
+         */
+        bool IsNull()
+        {
+            return m_ptr.IsNull();
+        }
+
+        /**
+         * The number of CowPs currently sharing this version of the
+         * object.  A result of 1 means the next Mutate will not clone.
+         *
+         * @return The shared reference count (0 for a null CowP).
+         */
+        std::uint32_t UseCount() const
+        {
+            return m_ptr.UseCount();
+        }
+
+    private:
+        // The factory builds the CowP around a combined-allocation SP.
+        template < typename T, typename P, typename... ARGS >
+        friend CowP< T, P > MakeCowP( ARGS&&... args );
+
+        // A constructor from an SP, for the factory's use.  Private so an
+        // aliasing SP cannot be slipped in: Mutate clones whatever the SP
+        // dereferences to, which is only the owned object when this class
+        // built the SP itself.
+        CowP( SP< TYPECOW, POLICY >&& p )
+        : m_ptr( std::move( p ) )
+        {
+        }
+
+        // Attributes ----------------------------------------------------------
+        // The underlying SP: the current version of the object and the
+        // strong count Mutate's sole-owner test reads.
+        SP< TYPECOW, POLICY > m_ptr;
+    };
+
+    /**
+     * Creates a CowP whose object and reference-count block share a SINGLE
+     * memory allocation (see MakeSP), forwarding the passed arguments to
+     * the object's constructor.
+     *
+     * @param args - the arguments to forward to TYPECOW's constructor.
+     *
+     * @return A CowP owning the newly constructed object.
+     */
+    template < typename TYPECOW, typename POLICY, typename... ARGS >
+    CowP< TYPECOW, POLICY > MakeCowP( ARGS&&... args )
+    {
+        return CowP< TYPECOW, POLICY >(
+            MakeSP< TYPECOW, POLICY >( std::forward< ARGS >( args )... ) );
+    }
+}; // End of namespace wbs
+
+#endif // #ifndef _COWP_H_
@@ -0,0 +1,374 @@
+/**
+ * Epoch.h
+ *
+ * Abstract:
+ * Epoch-based reclamation, allowing TP (temporary pointer) reads on
+ * concurrent hot paths without any reference-count traffic.  Readers wrap
+ * their accesses in a cheap per-thread ReadGuard; when epoch mode is
+ * enabled, UP::Delete and SP's final release hand doomed objects to this
+ * facility instead of freeing them inline, and the memory is only reclaimed
+ * once every reader that could have seen the object has left its guard.
+ *
+ * This is the classic three-epoch scheme: a global epoch advances only when
+ * every active reader has announced the current one, so an object retired
+ * in epoch E cannot still be referenced once the global epoch reaches E+2.
+ *
+ * @see TP.h UP.h SP.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _EPOCH_H_
+#define _EPOCH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * The Working Bits Systems namespace
+ */
+namespace wbs
+{
+    /**
+     * @class EpochReclaim
+     * The process-wide machinery behind ReadGuard: per-thread epoch slots,
+     * the global epoch, and the list of retired (doomed but not yet freed)
+     * objects.
+     *
+     * Readers are entirely lock-free: entering a guard is one store, one
+     * fence and a re-check; leaving is one store.  Retirement and
+     * collection take a mutex - they sit on the (rare) destruction path,
+     * not the read path, and a collection has to scan the reader slots
+     * anyway.
+     *
+     * Usage:
+     *     wbs::EpochReclaim::Enable();        // process setup
+     *     ...
+     *     {
+     *         wbs::ReadGuard guard;           // reader hot path
+     *         TP< Foo > p = sharedFoo;        // refcount-free access
+     *         Use( p );
+     *     }                                   // guard released
+     *
+     * Writers delete through UP / SP exactly as before; with epoch mode
+     * enabled those deletes are deferred behind the readers automatically.
+     *
+     * @note A thread that never leaves its ReadGuard blocks reclamation
+     *       for the whole process.  Guards are meant to span one read,
+     *       not a thread's lifetime.
+     */
+    class EpochReclaim
+    {
+    public:
+        // Turns epoch deferral on/off for the whole process.  With it off,
+        // ReadGuard still works (it just pins nothing) and deletes are
+        // inline as always.
+        static void Enable()
+        {
+            sm_enabled.store( true, std::memory_order_relaxed );
+        }
+
+        static void Disable()
+        {
+            sm_enabled.store( false, std::memory_order_relaxed );
+        }
+
+        static bool Enabled()
+        {
+            return sm_enabled.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Hands an object to the reclaimer.  The disposer runs (and the
+         * memory is freed) only after every reader active at the time of
+         * this call has left its guard.  Called by the smart pointers'
+         * delete paths when epoch mode is enabled; application code
+         * normally has no reason to call it directly.
+         *
+         * @param obj      - the doomed object.
+         * @param disposer - destroys/frees obj when it is safe to do so.
+         */
+        static void Retire( void* obj, void ( *disposer )( void* ) )
+        {
+            std::lock_guard< std::mutex > lock( Mutex() );
+
+            sm_retired = new RetireNode{
+                obj, disposer,
+                sm_globalEpoch.load( std::memory_order_relaxed ),
+                sm_retired };
+            ++sm_retiredCount;
+
+            // Collect opportunistically so the list cannot grow without
+            // bound when nobody pumps Collect().
+            if ( COLLECT_THRESHOLD <= sm_retiredCount )
+            {
+                CollectLocked();
+            }
+        }
+
+        /**
+         * Attempts to advance the epoch and frees every retired object
+         * that is now unreachable.  Call from a housekeeping point if
+         * retirement is bursty; otherwise the opportunistic collection in
+         * Retire keeps up on its own.
+         *
+         * @return The number of objects freed by this call.
+         */
+        static std::size_t Collect()
+        {
+            std::lock_guard< std::mutex > lock( Mutex() );
+
+            return CollectLocked();
+        }
+
+    private:
+        // The RAII reader guard is the only one that touches the slots.
+        friend class ReadGuard;
+
+        // How many retirements may accumulate before Retire collects on
+        // its own.
+        static constexpr std::size_t COLLECT_THRESHOLD = 64;
+
+        // A per-thread epoch announcement.  0 means quiescent (no guard
+        // held).  Slots are claimed on first use, returned on thread exit,
+        // and reused by later threads; they are never deallocated.
+        struct ThreadSlot
+        {
+            std::atomic< std::uint64_t > m_epoch{ 0 };
+            std::atomic< bool >          m_inUse{ true };
+            ThreadSlot*                  m_next = nullptr;
+        };
+
+        // One doomed object, remembering the epoch it was retired in.
+        struct RetireNode
+        {
+            void*         m_obj;
+            void          ( *m_disposer )( void* );
+            std::uint64_t m_epoch;
+            RetireNode*   m_next;
+        };
+
+        // Releases this thread's slot back for reuse on thread exit.
+        struct SlotHolder
+        {
+            ThreadSlot* m_slot = nullptr;
+
+            ~SlotHolder()
+            {
+                if ( nullptr != m_slot )
+                {
+                    m_slot->m_epoch.store( 0, std::memory_order_release );
+                    m_slot->m_inUse.store( false, std::memory_order_release );
+                }
+            }
+        };
+
+        // The calling thread's slot, claimed from the global list (reusing
+        // a released one when available) on first use.
+        static ThreadSlot* MySlot()
+        {
+            static thread_local SlotHolder holder;
+
+            if ( nullptr == holder.m_slot )
+            {
+                // Try to adopt a slot a finished thread released.
+                for ( ThreadSlot* slot =
+                          sm_slots.load( std::memory_order_acquire );
+                      nullptr != slot; slot = slot->m_next )
+                {
+                    bool expected = false;
+                    if ( slot->m_inUse.compare_exchange_strong(
+                             expected, true, std::memory_order_acq_rel ) )
+                    {
+                        holder.m_slot = slot;
+                        return slot;
+                    }
+                }
+
+                // None free: push a fresh slot onto the list.
+                ThreadSlot* slot = new ThreadSlot;
+                slot->m_next = sm_slots.load( std::memory_order_relaxed );
+                while ( !sm_slots.compare_exchange_weak(
+                            slot->m_next, slot,
+                            std::memory_order_release,
+                            std::memory_order_relaxed ) )
+                {
+                }
+                holder.m_slot = slot;
+            }
+
+            return holder.m_slot;
+        }
+
+        // Reader entry: announce the current global epoch.  The sequential
+        // fence orders the announcement before any of the guarded reads,
+        // and the re-check closes the window where the epoch advanced
+        // between the load and the store.
+        static void Enter()
+        {
+            ThreadSlot* slot = MySlot();
+
+            std::uint64_t epoch =
+                sm_globalEpoch.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                slot->m_epoch.store( epoch, std::memory_order_relaxed );
+                std::atomic_thread_fence( std::memory_order_seq_cst );
+
+                std::uint64_t now =
+                    sm_globalEpoch.load( std::memory_order_relaxed );
+                if ( now == epoch )
+                {
+                    break;
+                }
+                epoch = now;
+            }
+        }
+
+        // Reader exit: back to quiescent.  Release so the guarded reads
+        // complete before any collector sees the slot go quiet.
+        static void Exit()
+        {
+            MySlot()->m_epoch.store( 0, std::memory_order_release );
+        }
+
+        // The mutex serializing retirement and collection.  Function-local
+        // so the header stays self-contained.
+        static std::mutex& Mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        // Advances the epoch if every active reader has announced the
+        // current one, then frees everything retired at least two epochs
+        // ago.  Caller holds the mutex.
+        static std::size_t CollectLocked()
+        {
+            // Two successful advances are enough to age any eligible
+            // retirement past its grace period; stop early if a reader
+            // pins the epoch.
+            for ( int attempt = 0; attempt < 2; ++attempt )
+            {
+                std::uint64_t epoch =
+                    sm_globalEpoch.load( std::memory_order_relaxed );
+
+                bool pinned = false;
+                for ( ThreadSlot* slot =
+                          sm_slots.load( std::memory_order_acquire );
+                      nullptr != slot; slot = slot->m_next )
+                {
+                    std::uint64_t seen =
+                        slot->m_epoch.load( std::memory_order_acquire );
+                    if ( ( 0 != seen ) && ( seen != epoch ) )
+                    {
+                        pinned = true;
+                        break;
+                    }
+                }
+                if ( pinned )
+                {
+                    break;
+                }
+
+                sm_globalEpoch.store( epoch + 1,
+                                      std::memory_order_release );
+            }
+
+            // Split the list: anything retired two or more epochs ago is
+            // unreachable.  The survivors keep their (LIFO) order.
+            std::uint64_t safe =
+                sm_globalEpoch.load( std::memory_order_relaxed );
+            RetireNode*  keep     = nullptr;
+            RetireNode** keepTail = &keep;
+            RetireNode*  doomed   = nullptr;
+
+            RetireNode* node = sm_retired;
+            while ( nullptr != node )
+            {
+                RetireNode* next = node->m_next;
+                if ( node->m_epoch + 2 <= safe )
+                {
+                    // Prepending reverses the LIFO list, restoring
+                    // retirement order so dependent disposals (object
+                    // destructor before its block's free) run in order.
+                    node->m_next = doomed;
+                    doomed = node;
+                }
+                else
+                {
+                    *keepTail = node;
+                    keepTail = &node->m_next;
+                }
+                node = next;
+            }
+            *keepTail = nullptr;
+            sm_retired = keep;
+
+            // Dispose outside the list manipulation, oldest first.
+            std::size_t count = 0;
+            while ( nullptr != doomed )
+            {
+                RetireNode* next = doomed->m_next;
+                doomed->m_disposer( doomed->m_obj );
+                delete doomed;
+                doomed = next;
+                ++count;
+            }
+
+            sm_retiredCount -= count;
+
+            return count;
+        }
+
+        // Whether the smart-pointer delete paths defer through Retire.
+        static inline std::atomic< bool > sm_enabled{ false };
+
+        // The global epoch.  Starts above zero so a quiescent slot (0) can
+        // never be mistaken for an announcement.
+        static inline std::atomic< std::uint64_t > sm_globalEpoch{ 1 };
+
+        // The list of per-thread slots.  Grows to the high-water mark of
+        // concurrently live threads and is then reused forever.
+        static inline std::atomic< ThreadSlot* > sm_slots{ nullptr };
+
+        // The retired objects and their count, guarded by Mutex().
+        static inline RetireNode* sm_retired = nullptr;
+        static inline std::size_t sm_retiredCount = 0;
+    };
+
+    /**
+     * @class ReadGuard
+     * RAII epoch guard for refcount-free reads.  While an instance is
+     * alive, no object retired after the guard was entered will be freed,
+     * so TPs (and raw pointers) obtained from UPs/SPs may be dereferenced
+     * safely even if the owner releases them concurrently - provided the
+     * process runs with EpochReclaim enabled.
+     *
+     * Entering costs one store, one fence and a re-check; leaving costs a
+     * single store.  No atomic read-modify-write, no contention with other
+     * readers.
+     */
+    class ReadGuard
+    {
+    public:
+        ReadGuard()
+        {
+            EpochReclaim::Enter();
+        }
+
+        ~ReadGuard()
+        {
+            EpochReclaim::Exit();
+        }
+
+    private:
+        // A guard pins the calling thread's slot; copying one is
+        // meaningless.
+        ReadGuard( const ReadGuard& );
+        const ReadGuard& operator=( const ReadGuard& );
+    };
+}; // End of namespace wbs
+
+#endif // #ifndef _EPOCH_H_
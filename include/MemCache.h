@@ -8,39 +8,217 @@
  * a cache of up to 50% of the number of in-use allocations.  100 objects
  * allocated?  That will keep up to 50 cached memory allocations.
  *
+ * The cache is split into two levels: a small per-thread free list that the
+ * common alloc/free path touches with no synchronization at all, and shared
+ * overflow stacks - one per NUMA node - that threads exchange whole batches
+ * of blocks with.  Blocks freed on a node return to that node's stack and
+ * are preferentially reallocated there, so a block's memory stays local to
+ * the socket using it; remote stacks are only raided when the local one is
+ * dry.  The
+ * shared stack is a lock-free Treiber stack (the link pointers live inside
+ * the free blocks themselves), so even a sustained cross-thread alloc/free
+ * imbalance - producer thread allocating, consumer thread freeing - costs
+ * one CAS per block rather than a contended mutex.
+ *
+ * Blocks are bucketed by allocation size into a small fixed set of size
+ * classes, claimed on first use.  This makes it safe for an entire class
+ * hierarchy to share one MemCache base: a derived class's larger blocks are
+ * cached and recycled separately from a smaller sibling's, instead of the
+ * cache handing a too-small block to whichever class asks next.
+ *
+ * Block storage comes from mmap'd slabs: 2 MiB aligned regions carved into
+ * fixed-size blocks, so 100k cached objects occupy a handful of contiguous
+ * regions (and a handful of TLB entries) rather than 100k scattered malloc
+ * chunks.  Slabs are madvise'd for transparent huge pages, and building
+ * with WBS_MEMCACHE_HUGETLB additionally attempts explicitly reserved huge
+ * pages (MAP_HUGETLB) before falling back.  When trimming has brought all
+ * of a slab's outstanding blocks home, the whole slab is returned to the
+ * OS in one munmap.
+ *
+ * Contention-heavy classes - ones whose instances are written by several
+ * threads at once, like reference-count blocks - can additionally pass an
+ * ALIGNMENT: blocks are then rounded up to and allocated at that boundary,
+ * so at CACHE_LINE_SIZE every instance owns its cache line and two
+ * unrelated objects never false-share one.  Densely-allocated classes
+ * should leave it at 0 (natural alignment, tight packing).
+ *
  * @copyright Copyright(C) Working Bits Systems, LLC 2023
  */
 #ifndef _MEMCACHE_H_
 #define _MEMCACHE_H_
-#include <vector>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <new>
+
+#include "PtrProfile.h"
+
+#ifdef WBS_MEMCACHE_STATS
+#include <vector>
+#include <typeinfo>
+#endif
+
+// The slab backend maps large anonymous regions and carves them into
+// blocks, so cached objects pack densely instead of scattering across the
+// heap (fewer TLB entries, and eligible for huge pages).  It needs mmap;
+// on platforms without it the cache falls back to per-block heap
+// allocation, exactly as before.
+#ifndef _WIN32
+#define WBS_MEMCACHE_SLABS 1
+#include <sys/mman.h>
+#endif
+
+// NUMA awareness needs glibc's getcpu() wrapper (glibc 2.29+) to learn
+// the calling thread's node; without it every thread lands on shard 0,
+// which is exactly the old single-list behavior.
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 // The Working Bits Systems namespace
 namespace wbs
 {
+    /**
+     * The destructive-interference granularity the alignment mode below
+     * isolates contended objects to.  64 bytes is the L1 line size of
+     * every target we ship on; this is what the standard's
+     * std::hardware_destructive_interference_size reports there, without
+     * depending on library support for it.
+     */
+    inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * A point-in-time snapshot of one MemCache's counters, returned by
+     * MemCache< T >::Stats().  All fields are zero unless the library is
+     * built with WBS_MEMCACHE_STATS defined; with the macro off, none of the
+     * counter maintenance exists in the compiled code at all.
+     */
+    struct MemCacheStats
+    {
+        // Allocations served from the cache (local or shared list).
+        std::uint64_t m_hitCount = 0;
+
+        // Allocations that fell through to the system allocator.
+        std::uint64_t m_missCount = 0;
+
+        // Blocks currently cached (allocated from the system but not in use).
+        std::uint64_t m_cacheSize = 0;
+
+        // The most objects ever in use at once.
+        std::uint64_t m_inUseHighWater = 0;
+
+        // Total bytes currently retained by cached blocks.
+        std::uint64_t m_bytesRetained = 0;
+    };
+
+#ifdef WBS_MEMCACHE_STATS
+    /**
+     * A process-wide registry of every MemCache instantiated in the program,
+     * for feeding dashboards: each cache registers a snapshot function on
+     * first use, and Entries() returns the current set.  Only compiled when
+     * WBS_MEMCACHE_STATS is defined.
+     */
+    class MemCacheRegistry
+    {
+    public:
+        // One registered cache: the (implementation-mangled) name of the
+        // cached type, and a function returning its current snapshot.
+        struct Entry
+        {
+            const char* m_name;
+            MemCacheStats (*m_snapshot)();
+        };
+
+        // Adds a cache to the registry.  Called once per MemCache
+        // instantiation, from its registration hook.
+        static void Register( const char* name, MemCacheStats (*snapshot)() )
+        {
+            Lock().lock();
+            List().push_back( Entry{ name, snapshot } );
+            Lock().unlock();
+        }
+
+        // Returns a copy of the registered caches.  Call each entry's
+        // m_snapshot for its live counters.
+        static std::vector< Entry > Entries()
+        {
+            Lock().lock();
+            std::vector< Entry > ret = List();
+            Lock().unlock();
+
+            return ret;
+        }
+
+    private:
+        // Function-local statics dodge any initialization-order trouble with
+        // caches registering during static construction.
+        static std::mutex& Lock()
+        {
+            static std::mutex lock;
+            return lock;
+        }
+
+        static std::vector< Entry >& List()
+        {
+            static std::vector< Entry > list;
+            return list;
+        }
+    };
+#endif // WBS_MEMCACHE_STATS
     /**
      * Base class used to provide a performance boost for frequently allocated
      * and freed objects.  By keeping memory allocations in this cache, the
      * system overhead of memory allocations is reduced.  CACHE_RATE
      * determines the size of the cache as a percentage of the currently
      * allocated objects.  The template parameter for MemCache must be the
-     * inheriting class, allowing for the required static variables on a per-
-     * inheriting-class basis.
+     * inheriting class (or the root of an inheriting hierarchy), allowing for
+     * the required static variables on a per-inheriting-class basis.
      *
      * Usage: Publicly inherit this class.  E.g.:
      *        class Foo: public Memcache< Foo >
      *        {
      *        }
      *
-     * @note Array allocation operators are ignored for this implementation.
+     * The ALIGNMENT parameter (0, the default, means natural alignment)
+     * makes every block of this cache start at that boundary, with sizes
+     * rounded up to match so consecutive blocks never straddle it.  Pass
+     * CACHE_LINE_SIZE for classes whose instances several threads write
+     * concurrently (reference counts, per-object locks): each instance
+     * then owns its cache line, and updates to one never stall updates to
+     * its neighbor.  E.g.:
+     *        class Bar: public MemCache< Bar, CACHE_LINE_SIZE >
+     *        {
+     *        }
+     *
+     * @note The array allocation operators route through the same cache:
+     *       an array of a cached class (or a MakeUP< T[] > buffer of one)
+     *       gets a bucket for its total size like any other allocation,
+     *       falling back to the system allocator when its size doesn't
+     *       earn a bucket.
+     * @note Hierarchies deleting through a base pointer need a virtual
+     *       destructor (as they always have), so the compiler hands the
+     *       sized operator delete the most-derived size and the block lands
+     *       back in its own size class.
      */
-    template <typename T>
+    template <typename T, std::size_t ALIGNMENT = 0>
     class MemCache
     {
     public:
+        static_assert( ( 0 == ALIGNMENT ) ||
+                       ( 0 == ( ALIGNMENT & ( ALIGNMENT - 1 ) ) ),
+                       "ALIGNMENT must be zero (natural) or a power of "
+                       "two." );
+
         /**
          * Allocates memory of the provided size.  "new" calls this method with
-         * the size of the object needed for the class in question automatically.
+         * the size of the object needed for the class in question automatically
+         * - for a class derived from T, that is the derived size, which
+         * selects the derived class's own size bucket.
+         *
+         * The fast path pops a block off this thread's local free list with
+         * no synchronization.  When the local list runs dry, a batch of
+         * blocks is popped from the shared overflow stack, one CAS each,
+         * before falling back to the system allocator.
          *
          * @param size - the size of the memory blck to be allocated
          *
@@ -49,72 +227,921 @@ namespace wbs
          */
         void* operator new( size_t size )
         {
+            int bucket = BucketFor( size, true );
+            if ( 0 > bucket )
+            {
+                // More distinct sizes than we have buckets; this size is not
+                // cached.  (The sized operator delete makes the same lookup
+                // and frees it directly.)
+                void* uncached = SystemAlloc( size );
+#ifdef WBS_PTR_PROFILE
+                PtrProfile::RecordArmedAlloc( uncached );
+#endif
+                return uncached;
+            }
+
             void* ret = nullptr;
+            LocalCache& local = Local();
 
-            // Lock access to the cache
-            sm_lock.lock();
-            if ( 0 < sm_cache.size() )
+#ifdef WBS_MEMCACHE_STATS
+            // Make sure this cache is in the process-wide registry, and
+            // count the allocation (hits are derived as allocs - misses).
+            (void) sm_registrar;
+            sm_statAllocs.fetch_add( 1, std::memory_order_relaxed );
+#endif
+
+            if ( 0 < local.m_count[ bucket ] )
             {
-                ret = sm_cache.back();
-                sm_cache.pop_back();
+                // Fast path: thread-local, no lock, no atomics beyond the
+                // in-use counter.
+                ret = local.m_blocks[ bucket ][ --local.m_count[ bucket ] ];
             }
             else
             {
-                // Just need a buffer for the number of bytes.
-                ret = ::new char[ size ];
+                // Local list is empty; note which node we're on now, then
+                // refill a batch from this node's shared stack, raiding
+                // the other nodes' stacks only if ours is dry.
+                local.m_node = CurrentNode();
+
+                void* block;
+                while ( ( local.m_count[ bucket ] < BATCH_SIZE ) &&
+                        ( nullptr != ( block = PopAnyShared( local.m_node,
+                                                            bucket ) ) ) )
+                {
+                    local.m_blocks[ bucket ][ local.m_count[ bucket ]++ ] = block;
+                }
+
+                if ( 0 < local.m_count[ bucket ] )
+                {
+                    ret = local.m_blocks[ bucket ][ --local.m_count[ bucket ] ];
+                }
+                else
+                {
+                    // Nothing cached anywhere.  Refill a whole batch from
+                    // the slab backend in one mutex acquisition - blocks
+                    // never smaller than a freelist link, since a cached
+                    // block stores its stack link in its first
+                    // pointer-sized bytes - falling back to the heap if
+                    // slabs are unavailable.  The slabs are carved on
+                    // this node, and first touch keeps their pages here.
+                    int carved = AllocFromSlabs( local.m_node, bucket,
+                                                 BlockSize( size ),
+                                                 local.m_blocks[ bucket ],
+                                                 BATCH_SIZE );
+                    local.m_count[ bucket ] = carved;
+                    if ( 0 < carved )
+                    {
+                        ret = local.m_blocks[ bucket ]
+                                            [ --local.m_count[ bucket ] ];
+                    }
+                    else
+                    {
+                        ret = SystemAlloc( BlockSize( size ) );
+                    }
+#ifdef WBS_MEMCACHE_STATS
+                    sm_statMisses.fetch_add( 1, std::memory_order_relaxed );
+                    sm_totalBlocks[ bucket ].fetch_add(
+                        ( 0 < carved ) ? carved : 1,
+                        std::memory_order_relaxed );
+#endif
+                }
+            }
+
+            int nowInUse =
+                sm_inUse[ bucket ].fetch_add( 1, std::memory_order_relaxed ) + 1;
+            (void) nowInUse;
+
+#ifdef WBS_MEMCACHE_STATS
+            // Maintain the in-use high-water mark across all buckets.  The
+            // CAS loop only runs while the mark is actually rising.
+            int total = nowInUse;
+            for ( int i = 0; i < MAX_SIZE_CLASSES; ++i )
+            {
+                if ( i != bucket )
+                {
+                    total += sm_inUse[ i ].load( std::memory_order_relaxed );
+                }
+            }
+            int mark = sm_statHighWater.load( std::memory_order_relaxed );
+            while ( ( total > mark ) &&
+                    ( !sm_statHighWater.compare_exchange_weak(
+                          mark, total, std::memory_order_relaxed ) ) )
+            {
             }
-            ++sm_inUse;
-            sm_lock.unlock();
+#endif
+
+#ifdef WBS_PTR_PROFILE
+            PtrProfile::RecordArmedAlloc( ret );
+#endif
 
             return ret;
         }
 
         /**
          * Frees memory previously allocated by operator new.  May place memory
-         * into the internal cache for reuse.
+         * into the internal cache for reuse.  The compiler supplies the size
+         * of the object being deleted, which routes the block back to the
+         * size bucket it was allocated from.
          *
-         * @param mem - the pointer to the memory to be deleted (or cached).
+         * The fast path pushes the block onto this thread's local free list
+         * with no synchronization.  When the local list fills up, a batch of
+         * blocks is flushed to the shared overflow stack (one CAS each), and
+         * the shared stack is trimmed down to the CACHE_RATE percentage of
+         * in-use objects.
+         *
+         * @param mem  - the pointer to the memory to be deleted (or cached).
+         * @param size - the size of the object being deleted.
          */
-        void operator delete( void* mem )
+        void operator delete( void* mem, size_t size )
         {
-            sm_lock.lock();
+#ifdef WBS_PTR_PROFILE
+            PtrProfile::RecordFree( mem );
+#endif
+            int bucket = BucketFor( size, false );
+            if ( 0 > bucket )
+            {
+                // This size never got a bucket; it was allocated uncached.
+                SystemFree( mem );
+                return;
+            }
 
-            // Just put it on the cache, and if we end up needing to delete it,
-            // we will do so below.  In the rare case, this could cause an
-            // unnecessary reallocation of memory behind the vector, but the
-            // simplified code is worth it.
-            sm_cache.push_back( mem );
-            int size = sm_cache.size();
+            LocalCache& local = Local();
 
             // This object no longer in use.
-            --sm_inUse;
+            sm_inUse[ bucket ].fetch_sub( 1, std::memory_order_relaxed );
 
-            // Delete cache entries until we're down to our % of in use objects.
-            int targetCacheSize = sm_inUse * CACHE_RATE / 100;
-            while ( ( 0 != size ) && ( size > targetCacheSize ) )
+            if ( LOCAL_CAPACITY > local.m_count[ bucket ] )
             {
-                ::delete( (char*) sm_cache.back() );
-                sm_cache.pop_back();
-                --size;
+                // Fast path: thread-local, no lock.
+                local.m_blocks[ bucket ][ local.m_count[ bucket ]++ ] = mem;
             }
+            else
+            {
+                // Local list is full; flush a batch (and this block) to
+                // the freeing thread's node's shared stack, then trim the
+                // cache down to our % of in-use objects.
+                local.m_node = CurrentNode();
+
+                PushShared( local.m_node, bucket, mem );
+                while ( BATCH_SIZE < local.m_count[ bucket ] )
+                {
+                    PushShared( local.m_node, bucket,
+                                local.m_blocks[ bucket ]
+                                              [ --local.m_count[ bucket ] ] );
+                }
 
-            sm_lock.unlock();
+                TrimShared( local.m_node, bucket );
+            }
         }
 
-    private:
-        // The number of objects currently in use (new'd, but not yet deleted)
-        static inline int sm_inUse = 0;
+        /**
+         * The array allocation operators.  new TYPE[ n ] and its delete[]
+         * land here with the total size supplied both ways (the usual
+         * virtual-destructor rule applies), so array blocks cycle through
+         * the same size-class machinery as scalar ones.  Buffers of a
+         * recurring size - per-message I/O buffers and the like - earn a
+         * bucket and recycle; one-off sizes fall through to the system
+         * allocator as always.
+         */
+        void* operator new[]( size_t size )
+        {
+            return MemCache::operator new( size );
+        }
 
-        // The set of cached objects of type T.  We use a vector<void*> so the
-        // internal allocation will grow to some (assumed) steady-state size.
-        // This may slow initial delete operations as more object are added,
-        // but we expect the application to get to a steady state over time.
-        static inline std::vector< void * > sm_cache;
+        void operator delete[]( void* mem, size_t size )
+        {
+            MemCache::operator delete( mem, size );
+        }
 
-        // A lock for vector access to protect in a multithreaded environment.
-        static inline std::mutex sm_lock;
+        /**
+         * Pre-warms the cache with the given number of blocks in one batched
+         * pass.  Intended to be called during application initialization for
+         * hot classes, so the first requests hit steady-state allocation
+         * cost instead of filling the cache one slow ::new at a time.
+         *
+         * The reserved count also becomes a floor for cache trimming: the
+         * cache never shrinks below the total passed to Reserve, regardless
+         * of the CACHE_RATE percentage, so a pre-warmed pool survives the
+         * early period when few objects are in use yet.
+         *
+         * @param count - the number of blocks to pre-allocate into the cache.
+         * @param size  - the size of each block; defaults to sizeof( T ).
+         *                Pass sizeof( Derived ) to warm a derived class's
+         *                size bucket in a shared hierarchy cache.
+         */
+        static void Reserve( size_t count, size_t size = sizeof( T ) )
+        {
+            int bucket = BucketFor( size, true );
+            if ( 0 > bucket )
+            {
+                // No bucket available for this size; nothing to warm.
+                return;
+            }
 
+            sm_reserved[ bucket ].fetch_add( (int) count,
+                                             std::memory_order_relaxed );
+            int node = CurrentNode();
+            for ( size_t i = 0; i < count; ++i )
+            {
+                void* block;
+                if ( 1 != AllocFromSlabs( node, bucket, BlockSize( size ),
+                                          &block, 1 ) )
+                {
+                    block = SystemAlloc( BlockSize( size ) );
+                }
+                PushShared( node, bucket, block );
+#ifdef WBS_MEMCACHE_STATS
+                sm_totalBlocks[ bucket ].fetch_add(
+                    1, std::memory_order_relaxed );
+#endif
+            }
+        }
+
+        /**
+         * Returns a point-in-time snapshot of this cache's counters.  All
+         * zeros unless built with WBS_MEMCACHE_STATS; see MemCacheStats.
+         *
+         * @return The snapshot.
+         */
+        static MemCacheStats Stats()
+        {
+            MemCacheStats stats;
+
+#ifdef WBS_MEMCACHE_STATS
+            std::uint64_t allocs =
+                sm_statAllocs.load( std::memory_order_relaxed );
+            std::uint64_t misses =
+                sm_statMisses.load( std::memory_order_relaxed );
+            stats.m_missCount = misses;
+            stats.m_hitCount  = allocs - misses;
+            stats.m_inUseHighWater =
+                sm_statHighWater.load( std::memory_order_relaxed );
+
+            for ( int bucket = 0; bucket < MAX_SIZE_CLASSES; ++bucket )
+            {
+                // Cached = blocks obtained from the system minus blocks in
+                // use.  Both counters are relaxed, so the difference is
+                // momentarily approximate under concurrency.
+                std::int64_t cached =
+                    (std::int64_t) sm_totalBlocks[ bucket ].load(
+                        std::memory_order_relaxed )
+                    - sm_inUse[ bucket ].load( std::memory_order_relaxed );
+                if ( 0 < cached )
+                {
+                    stats.m_cacheSize += cached;
+                    stats.m_bytesRetained +=
+                        cached * BlockSize( sm_classSizes[ bucket ].load(
+                                      std::memory_order_relaxed ) );
+                }
+            }
+#endif
+
+            return stats;
+        }
+
+    private:
+        // Constants -----------------------------------------------------------
         static constexpr int CACHE_RATE = 50;
+
+        // The capacity of each per-thread free list, and the number of blocks
+        // a thread keeps when flushing its full local list to the shared
+        // overflow (the rest of the batch moves to the shared stack).
+        static constexpr int LOCAL_CAPACITY = 32;
+        static constexpr int BATCH_SIZE     = LOCAL_CAPACITY / 2;
+
+        // The number of distinct allocation sizes (size classes) one cache
+        // can hold.  Sizes are claimed first-come-first-served; a hierarchy
+        // with more distinct sizes than this simply has its extra sizes pass
+        // through to the system allocator uncached.
+        static constexpr int MAX_SIZE_CLASSES = 8;
+
+        // The number of NUMA-node shards for the shared stacks and slab
+        // lists.  Nodes beyond this fold onto a shard by modulo, which
+        // costs locality but stays correct.
+        static constexpr int MAX_NUMA_NODES = 8;
+
+        // The NUMA node the calling thread is running on right now, from
+        // glibc's getcpu() - which goes through the vDSO, a few
+        // nanoseconds rather than a kernel round trip (the raw
+        // SYS_getcpu syscall does not).  Platforms without it report
+        // node 0, collapsing the shards back into one list.
+        static int CurrentNode()
+        {
+#if defined( __linux__ ) && defined( __GLIBC__ ) && \
+    ( ( 2 < __GLIBC__ ) || ( ( 2 == __GLIBC__ ) && ( 29 <= __GLIBC_MINOR__ ) ) )
+            unsigned cpu;
+            unsigned node;
+            if ( 0 == getcpu( &cpu, &node ) )
+            {
+                return (int) ( node % MAX_NUMA_NODES );
+            }
+#endif
+            return 0;
+        }
+
+        // Size classes --------------------------------------------------------
+        // Maps an allocation size to its bucket index.  The common case (a
+        // class's one-and-only size, claimed on its first allocation) is a
+        // match on the first slot or two, so the scan is a couple of relaxed
+        // loads on the hot path.  When claim is set, an unclaimed slot is
+        // claimed for this size with a CAS; returns -1 if every slot belongs
+        // to some other size.
+        static int BucketFor( size_t size, bool claim )
+        {
+            for ( int i = 0; i < MAX_SIZE_CLASSES; ++i )
+            {
+                size_t slot = sm_classSizes[ i ].load( std::memory_order_acquire );
+                if ( size == slot )
+                {
+                    return i;
+                }
+                if ( ( 0 == slot ) && claim )
+                {
+                    if ( sm_classSizes[ i ].compare_exchange_strong(
+                             slot, size,
+                             std::memory_order_acq_rel ) )
+                    {
+                        return i;
+                    }
+                    // Somebody else claimed the slot first; it may even have
+                    // been claimed for our size.
+                    if ( size == slot )
+                    {
+                        return i;
+                    }
+                }
+            }
+
+            return -1;
+        }
+
+        // The allocation size to use for a block of the given object size:
+        // never smaller than a freelist link, and under an ALIGNMENT,
+        // rounded up to a multiple of it so consecutively carved blocks
+        // all start on (and none straddle) the boundary.
+        static size_t BlockSize( size_t size )
+        {
+            size_t block =
+                ( size < sizeof( FreeNode ) ) ? sizeof( FreeNode ) : size;
+            if constexpr ( 0 != ALIGNMENT )
+            {
+                block = ( ( block + ALIGNMENT - 1 ) / ALIGNMENT ) * ALIGNMENT;
+            }
+
+            return block;
+        }
+
+        // The system-allocator fallbacks behind the slabs and the uncached
+        // sizes.  An aligned cache must use the aligned forms - a plain
+        // new char[] only promises max_align_t - and the frees mirror the
+        // allocation either way.
+        static void* SystemAlloc( size_t size )
+        {
+            if constexpr ( 0 != ALIGNMENT )
+            {
+                return ::operator new( size, std::align_val_t( ALIGNMENT ) );
+            }
+            else
+            {
+                return ::new char[ size ];
+            }
+        }
+
+        static void SystemFree( void* mem )
+        {
+            if constexpr ( 0 != ALIGNMENT )
+            {
+                ::operator delete( mem, std::align_val_t( ALIGNMENT ) );
+            }
+            else
+            {
+                ::delete[] (char*) mem;
+            }
+        }
+
+        // Shared overflow stack -----------------------------------------------
+        // A node view of a cached block: a free block's first pointer-sized
+        // bytes link it to the next block in the stack.  No separate node
+        // allocations are ever made.
+        struct FreeNode
+        {
+            FreeNode* m_next;
+        };
+
+        // The head of each bucket's Treiber stack is a single 64-bit word
+        // packing the top-block pointer in the low 48 bits with a 16-bit tag
+        // in the high bits.  The tag is bumped on every pop, which makes the
+        // compare-exchange fail if the stack was popped and re-pushed behind
+        // our back with the same top block (the classic ABA hazard) - that
+        // would otherwise let a stale next pointer be installed as the new
+        // head.  Packing into one word keeps the head exchangeable with a
+        // plain 8-byte CAS on every platform, with no double-width-CAS
+        // library support needed.  User-space heap pointers fit in 48 bits
+        // on all of our targets; the 16-bit tag would need to wrap exactly
+        // 65536 times within one thread's CAS window to slip an ABA through.
+        static constexpr std::uint64_t HEAD_PTR_MASK = 0x0000FFFFFFFFFFFFull;
+        static constexpr int           HEAD_TAG_SHIFT = 48;
+
+        static FreeNode* HeadPtr( std::uint64_t head )
+        {
+            return reinterpret_cast< FreeNode* >( head & HEAD_PTR_MASK );
+        }
+
+        static std::uint64_t MakeHead( FreeNode* top, std::uint64_t tag )
+        {
+            return ( reinterpret_cast< std::uintptr_t >( top ) & HEAD_PTR_MASK )
+                   | ( tag << HEAD_TAG_SHIFT );
+        }
+
+        static std::uint64_t HeadTag( std::uint64_t head )
+        {
+            return head >> HEAD_TAG_SHIFT;
+        }
+
+        // Pushes a freed block onto a node's stack for a bucket with a
+        // single CAS (per retry).  Release ordering publishes the link
+        // just written.
+        static void PushShared( int numaNode, int bucket, void* mem )
+        {
+            FreeNode* node = static_cast< FreeNode* >( mem );
+            std::uint64_t oldHead =
+                sm_shared[ numaNode ][ bucket ].load(
+                    std::memory_order_relaxed );
+            std::uint64_t newHead;
+
+            do
+            {
+                node->m_next = HeadPtr( oldHead );
+                newHead = MakeHead( node, HeadTag( oldHead ) );
+            } while ( !sm_shared[ numaNode ][ bucket ].compare_exchange_weak(
+                          oldHead, newHead,
+                          std::memory_order_release,
+                          std::memory_order_relaxed ) );
+
+            sm_sharedCount[ numaNode ][ bucket ].fetch_add(
+                1, std::memory_order_relaxed );
+        }
+
+        // Pops a block from a node's stack for a bucket, or returns
+        // nullptr if it is empty.  The tag bump on every successful pop
+        // provides the ABA protection described above.
+        static void* PopShared( int numaNode, int bucket )
+        {
+            std::uint64_t oldHead =
+                sm_shared[ numaNode ][ bucket ].load(
+                    std::memory_order_acquire );
+            std::uint64_t newHead;
+            FreeNode* top;
+
+            do
+            {
+                top = HeadPtr( oldHead );
+                if ( nullptr == top )
+                {
+                    return nullptr;
+                }
+                newHead = MakeHead( top->m_next, HeadTag( oldHead ) + 1 );
+            } while ( !sm_shared[ numaNode ][ bucket ].compare_exchange_weak(
+                          oldHead, newHead,
+                          std::memory_order_acquire,
+                          std::memory_order_acquire ) );
+
+            sm_sharedCount[ numaNode ][ bucket ].fetch_sub(
+                1, std::memory_order_relaxed );
+
+            return top;
+        }
+
+        // Pops from the caller's node first, then raids the other nodes'
+        // stacks.  A remote block is better than a system allocation, and
+        // once this thread frees it, it comes home to the local stack.
+        static void* PopAnyShared( int numaNode, int bucket )
+        {
+            void* block = PopShared( numaNode, bucket );
+            for ( int other = 0;
+                  ( nullptr == block ) && ( other < MAX_NUMA_NODES );
+                  ++other )
+            {
+                if ( other != numaNode )
+                {
+                    block = PopShared( other, bucket );
+                }
+            }
+
+            return block;
+        }
+
+        // A bucket's cached block count summed across every node's stack.
+        // Approximate under concurrency, like the per-node counters.
+        static int SharedCount( int bucket )
+        {
+            int count = 0;
+            for ( int node = 0; node < MAX_NUMA_NODES; ++node )
+            {
+                count += sm_sharedCount[ node ][ bucket ].load(
+                    std::memory_order_relaxed );
+            }
+
+            return count;
+        }
+
+        // Pops and deletes a bucket's shared stack entries until we're down
+        // to our % of in-use objects.  The target is bucket-wide but the
+        // trimming drains the caller's own node, so a node that stops
+        // freeing stops being trimmed.  Both counters are approximate
+        // under concurrency, which only makes the cache size momentarily
+        // off by a few blocks.
+        static void TrimShared( int numaNode, int bucket )
+        {
+            // The pre-warmed Reserve count is a floor under the usual
+            // percentage-of-in-use target.
+            int targetCacheSize =
+                sm_inUse[ bucket ].load( std::memory_order_relaxed )
+                * CACHE_RATE / 100;
+            int reserved =
+                sm_reserved[ bucket ].load( std::memory_order_relaxed );
+            if ( targetCacheSize < reserved )
+            {
+                targetCacheSize = reserved;
+            }
+
+            while ( SharedCount( bucket ) > targetCacheSize )
+            {
+                void* block = PopShared( numaNode, bucket );
+                if ( nullptr == block )
+                {
+                    break;
+                }
+                if ( !ReturnToSlab( bucket, block ) )
+                {
+                    SystemFree( block );
+                }
+#ifdef WBS_MEMCACHE_STATS
+                sm_totalBlocks[ bucket ].fetch_sub(
+                    1, std::memory_order_relaxed );
+#endif
+            }
+        }
+
+        // Slab backend --------------------------------------------------------
+        // Blocks are carved from SLAB_BYTES-sized, SLAB_BYTES-aligned mmap
+        // regions, one set of slabs per bucket.  The alignment lets a
+        // block find its slab with a mask.  All slab state is guarded by
+        // SlabMutex(): slabs are only touched on the miss and trim paths,
+        // never on the cached fast paths.
+        static constexpr std::size_t SLAB_BYTES = 2u * 1024 * 1024;
+
+        // The header at the start of each slab.  Blocks follow, starting
+        // at the first max-aligned offset past the header.
+        struct Slab
+        {
+            Slab*       m_next;      // This bucket's slab list.
+            Slab*       m_spareNext; // This bucket's slabs-with-spares list.
+            FreeNode*   m_spare;     // Blocks returned home by trimming.
+            std::size_t m_cursor;    // Carve offset for never-used space.
+            int         m_carved;    // Blocks handed out at least once.
+            int         m_returned;  // Blocks currently on m_spare.
+        };
+
+        // The first block's offset within a slab.  The slab base is
+        // SLAB_BYTES-aligned and BlockSize keeps every carve a multiple of
+        // the cache's ALIGNMENT, so starting the first block on the larger
+        // of ALIGNMENT and max_align keeps every block aligned.
+        static constexpr std::size_t SlabDataOffset()
+        {
+            constexpr std::size_t align =
+                ( ALIGNMENT > alignof( std::max_align_t ) )
+                    ? ALIGNMENT
+                    : alignof( std::max_align_t );
+            return ( ( sizeof( Slab ) + align - 1 ) / align ) * align;
+        }
+
+        static std::mutex& SlabMutex()
+        {
+            static std::mutex lock;
+            return lock;
+        }
+
+#ifdef WBS_MEMCACHE_SLABS
+        // Maps one slab, aligned to its own size (over-map and trim the
+        // excess), and advises the kernel to back it with huge pages.
+        // Building with WBS_MEMCACHE_HUGETLB tries explicitly reserved
+        // huge pages first.  Returns nullptr if the system is out of
+        // address space.
+        static void* MapSlab()
+        {
+            void* raw = MAP_FAILED;
+
+#if defined( WBS_MEMCACHE_HUGETLB ) && defined( MAP_HUGETLB )
+            // Explicit huge pages come back naturally aligned.
+            raw = mmap( nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+            if ( MAP_FAILED != raw )
+            {
+                return raw;
+            }
+            // The huge-page pool may be empty; fall through to the normal
+            // path below.
+#endif
+
+            raw = mmap( nullptr, SLAB_BYTES * 2, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            if ( MAP_FAILED == raw )
+            {
+                return nullptr;
+            }
+
+            std::uintptr_t base =
+                ( reinterpret_cast< std::uintptr_t >( raw )
+                  + SLAB_BYTES - 1 )
+                & ~( static_cast< std::uintptr_t >( SLAB_BYTES ) - 1 );
+            std::size_t front =
+                base - reinterpret_cast< std::uintptr_t >( raw );
+            if ( 0 < front )
+            {
+                munmap( raw, front );
+            }
+            std::size_t back = SLAB_BYTES - front;
+            if ( 0 < back )
+            {
+                munmap( reinterpret_cast< void* >( base + SLAB_BYTES ),
+                        back );
+            }
+
+#ifdef MADV_HUGEPAGE
+            // An aligned 2 MiB anonymous region is exactly what
+            // transparent huge pages want.
+            madvise( reinterpret_cast< void* >( base ), SLAB_BYTES,
+                     MADV_HUGEPAGE );
+#endif
+
+            return reinterpret_cast< void* >( base );
+        }
+
+        // Produces up to want blocks for a bucket from the caller's node's
+        // slabs under one SlabMutex acquisition: spares trims returned
+        // first, then fresh carves from the current slab, mapping a brand
+        // new slab when the current one is full.  Spares are found through
+        // sm_spareSlabs - the list of exactly those slabs holding spares -
+        // so each block costs O(1) no matter how many slabs are live.  New
+        // slabs are mapped by (and first carved on) the local node, so
+        // first-touch placement keeps their pages in local DRAM.  Returns
+        // the number of blocks written to blocks[]; zero when mmap fails
+        // (caller falls back to the heap) or the block cannot fit a slab
+        // at all.
+        static int AllocFromSlabs( int numaNode, int bucket,
+                                   std::size_t blockSize,
+                                   void** blocks, int want )
+        {
+            if ( SLAB_BYTES - SlabDataOffset() < blockSize )
+            {
+                return 0;
+            }
+
+            std::lock_guard< std::mutex > lock( SlabMutex() );
+
+            int filled = 0;
+
+            // Reuse returned blocks before carving new space.  A slab is
+            // on sm_spareSlabs exactly while m_spare is non-empty, so it
+            // is unlinked the moment its last spare is handed out.
+            while ( filled < want )
+            {
+                Slab* slab = sm_spareSlabs[ numaNode ][ bucket ];
+                if ( nullptr == slab )
+                {
+                    break;
+                }
+
+                FreeNode* node = slab->m_spare;
+                slab->m_spare = node->m_next;
+                --slab->m_returned;
+                blocks[ filled++ ] = node;
+
+                if ( nullptr == slab->m_spare )
+                {
+                    sm_spareSlabs[ numaNode ][ bucket ] = slab->m_spareNext;
+                    slab->m_spareNext = nullptr;
+                }
+            }
+
+            while ( filled < want )
+            {
+                Slab* slab = sm_slabs[ numaNode ][ bucket ];
+                if ( ( nullptr == slab ) ||
+                     ( SLAB_BYTES - slab->m_cursor < blockSize ) )
+                {
+                    void* mem = MapSlab();
+                    if ( nullptr == mem )
+                    {
+                        break;
+                    }
+
+                    slab = static_cast< Slab* >( mem );
+                    slab->m_next = sm_slabs[ numaNode ][ bucket ];
+                    slab->m_spareNext = nullptr;
+                    slab->m_spare = nullptr;
+                    slab->m_cursor = SlabDataOffset();
+                    slab->m_carved = 0;
+                    slab->m_returned = 0;
+                    sm_slabs[ numaNode ][ bucket ] = slab;
+                }
+
+                while ( ( filled < want ) &&
+                        ( blockSize <= SLAB_BYTES - slab->m_cursor ) )
+                {
+                    blocks[ filled++ ] =
+                        reinterpret_cast< char* >( slab ) + slab->m_cursor;
+                    slab->m_cursor += blockSize;
+                    ++slab->m_carved;
+                }
+            }
+
+            return filled;
+        }
+
+        // Hands a trimmed block back to the slab it was carved from,
+        // whichever node's list that slab lives on (blocks may be freed
+        // far from home).  Returns false if the block is not slab-backed
+        // (it came from the heap fallback; the caller deletes it).  When
+        // every outstanding block of a non-current slab is home, the whole
+        // slab goes back to the OS in one munmap.
+        static bool ReturnToSlab( int bucket, void* block )
+        {
+            Slab* home = reinterpret_cast< Slab* >(
+                reinterpret_cast< std::uintptr_t >( block )
+                & ~( static_cast< std::uintptr_t >( SLAB_BYTES ) - 1 ) );
+
+            std::lock_guard< std::mutex > lock( SlabMutex() );
+
+            for ( int node = 0; node < MAX_NUMA_NODES; ++node )
+            {
+                Slab* prev = nullptr;
+                for ( Slab* slab = sm_slabs[ node ][ bucket ];
+                      nullptr != slab; prev = slab, slab = slab->m_next )
+                {
+                    if ( slab != home )
+                    {
+                        continue;
+                    }
+
+                    FreeNode* freed = static_cast< FreeNode* >( block );
+                    bool firstSpare = ( nullptr == slab->m_spare );
+                    freed->m_next = slab->m_spare;
+                    slab->m_spare = freed;
+                    ++slab->m_returned;
+
+                    // Gaining its first spare puts the slab on the
+                    // bucket's slabs-with-spares list, where the miss path
+                    // finds it without scanning.
+                    if ( firstSpare )
+                    {
+                        slab->m_spareNext = sm_spareSlabs[ node ][ bucket ];
+                        sm_spareSlabs[ node ][ bucket ] = slab;
+                    }
+
+                    // The current (head) slab is kept as the carving
+                    // target; any older slab whose blocks have all come
+                    // home is done.
+                    if ( ( nullptr != prev ) &&
+                         ( slab->m_returned == slab->m_carved ) )
+                    {
+                        prev->m_next = slab->m_next;
+                        UnlinkSpareSlab( node, bucket, slab );
+                        munmap( slab, SLAB_BYTES );
+                    }
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Drops a slab from its bucket's slabs-with-spares list ahead of
+        // its munmap.  A fully-returned slab is always on the list, so
+        // the walk is only as long as the list itself and only runs on
+        // the rare whole-slab-release path.  Caller holds SlabMutex().
+        static void UnlinkSpareSlab( int node, int bucket, Slab* slab )
+        {
+            Slab** link = &sm_spareSlabs[ node ][ bucket ];
+            while ( nullptr != *link )
+            {
+                if ( slab == *link )
+                {
+                    *link = slab->m_spareNext;
+                    return;
+                }
+                link = &( *link )->m_spareNext;
+            }
+        }
+#else // !WBS_MEMCACHE_SLABS
+        // No mmap on this platform: every block comes from (and returns
+        // to) the heap.
+        static int AllocFromSlabs( int, int, std::size_t, void**, int )
+        {
+            return 0;
+        }
+
+        static bool ReturnToSlab( int, void* )
+        {
+            return false;
+        }
+#endif // WBS_MEMCACHE_SLABS
+
+        // A small per-thread free list per size bucket.  The common
+        // alloc/free path only touches this structure, so it needs no
+        // synchronization.  When the owning thread exits, any blocks still
+        // held locally are handed back to the shared overflow stack so they
+        // are not leaked.
+        struct LocalCache
+        {
+            void* m_blocks[ MAX_SIZE_CLASSES ][ LOCAL_CAPACITY ];
+            int   m_count[ MAX_SIZE_CLASSES ] = {};
+
+            // The NUMA node this thread last saw itself on; refreshed on
+            // the slow paths, where the getcpu cost is noise.
+            int   m_node = CurrentNode();
+
+            ~LocalCache()
+            {
+                for ( int bucket = 0; bucket < MAX_SIZE_CLASSES; ++bucket )
+                {
+                    while ( 0 < m_count[ bucket ] )
+                    {
+                        PushShared( m_node, bucket,
+                                    m_blocks[ bucket ][ --m_count[ bucket ] ] );
+                    }
+                    TrimShared( m_node, bucket );
+                }
+            }
+        };
+
+        // Accessor for this thread's local free list.  A function-local
+        // thread_local gets us per-thread construction on first use and a
+        // destructor call (the flush above) at thread exit.
+        static LocalCache& Local()
+        {
+            static thread_local LocalCache cache;
+            return cache;
+        }
+
+        // Attributes ----------------------------------------------------------
+        // The sizes claimed by each bucket; 0 means the slot is still free.
+        // Claimed slots are never released for the life of the process.
+        static inline std::atomic< size_t > sm_classSizes[ MAX_SIZE_CLASSES ] = {};
+
+        // The number of objects currently in use (new'd, but not yet
+        // deleted) in each bucket, across all threads.
+        static inline std::atomic< int > sm_inUse[ MAX_SIZE_CLASSES ] = {};
+
+        // The shared overflow stacks of cached blocks - one per NUMA node
+        // per bucket (the packed head word described above) - and an
+        // approximate count of the blocks each holds, used for trimming.
+        static inline std::atomic< std::uint64_t >
+            sm_shared[ MAX_NUMA_NODES ][ MAX_SIZE_CLASSES ] = {};
+
+        static inline std::atomic< int >
+            sm_sharedCount[ MAX_NUMA_NODES ][ MAX_SIZE_CLASSES ] = {};
+
+        // The number of blocks pre-warmed via Reserve into each bucket; the
+        // cache never trims a bucket below this count.
+        static inline std::atomic< int > sm_reserved[ MAX_SIZE_CLASSES ] = {};
+
+        // Each node's slabs for each bucket, newest first (the head is the
+        // carving target).  Guarded by SlabMutex().
+        static inline Slab* sm_slabs[ MAX_NUMA_NODES ][ MAX_SIZE_CLASSES ] = {};
+
+        // Exactly those slabs whose m_spare list is non-empty, linked
+        // through m_spareNext, so the miss path reclaims spares without
+        // walking the full slab list.  Guarded by SlabMutex().
+        static inline Slab* sm_spareSlabs[ MAX_NUMA_NODES ]
+                                         [ MAX_SIZE_CLASSES ] = {};
+
+#ifdef WBS_MEMCACHE_STATS
+        // Statistics counters (see Stats()).  All relaxed atomics; the only
+        // one on the pure fast path is the allocation count.
+        static inline std::atomic< std::uint64_t > sm_statAllocs = 0;
+        static inline std::atomic< std::uint64_t > sm_statMisses = 0;
+        static inline std::atomic< int >           sm_statHighWater = 0;
+
+        // Blocks currently obtained from the system per bucket (in use or
+        // cached); only updated on the slow paths.
+        static inline std::atomic< int > sm_totalBlocks[ MAX_SIZE_CLASSES ] = {};
+
+        // Registers this cache with the process-wide registry when the class
+        // is first used (the registration hook is odr-used from operator
+        // new).
+        struct Registrar
+        {
+            Registrar()
+            {
+                MemCacheRegistry::Register( typeid( T ).name(),
+                                            &MemCache< T, ALIGNMENT >::Stats );
+            }
+        };
+        static inline Registrar sm_registrar;
+#endif
     };
 }
 
@@ -0,0 +1,289 @@
+/**
+ * ObjectPool.h
+ *
+ * Abstract:
+ * A pool that recycles constructed OBJECTS, not just their memory.
+ * MemCache removes the allocation cost, but a class whose constructor
+ * does real work - reserving buffers, building maps - pays that work
+ * again on every new/delete cycle.  ObjectPool hands out UP-based
+ * handles whose release returns the live object to the pool after
+ * calling its Reset() method, so the next Acquire gets a ready-to-use
+ * object for the cost of a pop and a Reset instead of a full
+ * construct/destruct round trip.
+ *
+ * The pool keeps its cached population in proportion to the in-use
+ * population, with the same percentage logic MemCache uses for its
+ * block cache (see CACHE_RATE there), and the same Reserve() floor for
+ * pre-warming.
+ *
+ * @see UP.h MemCache.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _OBJECTPOOL_H_
+#define _OBJECTPOOL_H_
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "UP.h"
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    // Detects a callable Reset() method, which the pool requires: Reset is
+    // what returns a recycled object to its ready state in place of the
+    // destructor/constructor pair it skips.
+    template< typename TYPE, typename = void >
+    struct HasReset : std::false_type {};
+
+    template< typename TYPE >
+    struct HasReset< TYPE, std::void_t<
+        decltype( std::declval< TYPE& >().Reset() ) > > : std::true_type {};
+
+    /**
+     * @class ObjectPool
+     *
+     * A pool of constructed objects of one class.  Acquire() pops a
+     * recycled object (constructing a fresh one only when the pool is
+     * empty) and wraps it in a Handle - a UP whose deleter returns the
+     * object here instead of destroying it.  The handle otherwise behaves
+     * like any UP: it moves, it releases on destruction, and the object
+     * is inaccessible to the pool while the handle owns it.
+     *
+     * Reset() is called at RELEASE time, not acquire time, so whatever
+     * memory an object holds onto across recycling (a reserved buffer, a
+     * cleared-but-allocated map) stays warm and the release path absorbs
+     * the cleanup cost.
+     *
+     * @note Handles must not outlive their pool; the pool's destructor
+     *       destroys only the objects that have been returned.
+     * @note The free list is guarded by a mutex.  The handout is a pop
+     *       under an uncontended lock - tens of nanoseconds - which the
+     *       constructor work being skipped dwarfs; classes cheap enough
+     *       for that to matter belong in MemCache, not here.
+     */
+    template< typename TYPE >
+    class ObjectPool
+    {
+        static_assert( HasReset< TYPE >::value,
+                       "ObjectPool requires TYPE to provide Reset(), which "
+                       "returns a used object to its ready state" );
+
+    public:
+        // Types ---------------------------------------------------------------
+        /**
+         * The handle deleter: returns the object to its pool, or plain-
+         * deletes it when default-constructed (a handle that outlived a
+         * deliberate pool shutdown can be given this way).
+         */
+        class Returner
+        {
+        public:
+            Returner()
+            {
+                m_pool = nullptr;
+            }
+
+            explicit Returner( ObjectPool* pool )
+            {
+                m_pool = pool;
+            }
+
+            void operator()( TYPE* obj ) const
+            {
+                if ( nullptr != m_pool )
+                {
+                    m_pool->Return( obj );
+                }
+                else
+                {
+                    delete obj;
+                }
+            }
+
+        private:
+            ObjectPool* m_pool;
+        };
+
+        /**
+         * The owning handle Acquire hands out: a UP that releases back to
+         * the pool.
+         */
+        using Handle = UP< TYPE, Returner >;
+
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Constructs an empty pool.  Objects are created on demand, or up
+         * front via Reserve().
+         */
+        ObjectPool()
+        {
+            m_inUse = 0;
+            m_reserved = 0;
+        }
+
+        /**
+         * The Destructor.  Destroys every pooled object.  Objects still
+         * out under a Handle are NOT destroyed here - their handles must
+         * be released (or the objects handed off) before the pool goes
+         * away.
+         */
+        ~ObjectPool()
+        {
+            for ( TYPE* obj : m_free )
+            {
+                delete obj;
+            }
+        }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Hands out an object: a recycled one when available (already
+         * Reset by its previous release), else a freshly constructed one.
+         *
+         * @param args - the arguments forwarded to TYPE's constructor,
+         *               used only when no recycled object is available.
+         *               Recycled objects keep their Reset() state.
+         *
+         * @return A Handle owning the object.
+         */
+        template< typename... ARGS >
+        Handle Acquire( ARGS&&... args )
+        {
+            TYPE* obj = nullptr;
+            {
+                std::lock_guard< std::mutex > hold( m_lock );
+                if ( !m_free.empty() )
+                {
+                    obj = m_free.back();
+                    m_free.pop_back();
+                }
+            }
+
+            if ( nullptr == obj )
+            {
+                obj = new TYPE( std::forward< ARGS >( args )... );
+            }
+
+            m_inUse.fetch_add( 1, std::memory_order_relaxed );
+
+            return Handle( obj, Returner( this ) );
+        }
+
+        /**
+         * Pre-warms the pool with the given number of constructed objects
+         * in one pass, so the first requests skip construction cost.  As
+         * with MemCache::Reserve, the count also becomes a floor under the
+         * percentage-based trimming, keeping the pre-warmed population
+         * alive through the early period when little is in use yet.
+         *
+         * @param count - the number of objects to pre-construct.
+         * @param args  - the arguments forwarded to each constructor.
+         */
+        template< typename... ARGS >
+        void Reserve( std::size_t count, ARGS&&... args )
+        {
+            std::vector< TYPE* > warmed;
+            warmed.reserve( count );
+            for ( std::size_t i = 0; i < count; ++i )
+            {
+                warmed.push_back( new TYPE( args... ) );
+            }
+
+            std::lock_guard< std::mutex > hold( m_lock );
+            m_free.insert( m_free.end(), warmed.begin(), warmed.end() );
+            m_reserved += static_cast< int >( count );
+        }
+
+        /**
+         * The number of objects currently out under handles.  Approximate
+         * under concurrency, like MemCache's counters.
+         */
+        int InUse() const
+        {
+            return m_inUse.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * The number of recycled objects waiting in the pool.
+         */
+        int Cached()
+        {
+            std::lock_guard< std::mutex > hold( m_lock );
+
+            return static_cast< int >( m_free.size() );
+        }
+
+    private:
+        // Constructors, destructor, and Assignment operator -------------------
+        // A pool owns its objects outright; copying one is meaningless.
+        ObjectPool( const ObjectPool& );
+        const ObjectPool& operator=( const ObjectPool& );
+
+        // Constants -----------------------------------------------------------
+        // Max cached objects as a percentage of in-use objects, mirroring
+        // MemCache's block-cache sizing.
+        static constexpr int CACHE_RATE = 50;
+
+        // Methods -------------------------------------------------------------
+        // Takes a handle's object back: Reset it, pool it, and trim the
+        // pool down to our % of in-use objects (never below the Reserve
+        // floor).  Called by Returner.
+        void Return( TYPE* obj )
+        {
+            obj->Reset();
+
+            int nowInUse =
+                m_inUse.fetch_sub( 1, std::memory_order_relaxed ) - 1;
+
+            int targetCacheSize = nowInUse * CACHE_RATE / 100;
+
+            std::vector< TYPE* > doomed;
+            {
+                std::lock_guard< std::mutex > hold( m_lock );
+
+                if ( targetCacheSize < m_reserved )
+                {
+                    targetCacheSize = m_reserved;
+                }
+
+                m_free.push_back( obj );
+                while ( static_cast< int >( m_free.size() )
+                        > targetCacheSize )
+                {
+                    doomed.push_back( m_free.back() );
+                    m_free.pop_back();
+                }
+            }
+
+            // The destructors run outside the lock.
+            for ( TYPE* dead : doomed )
+            {
+                delete dead;
+            }
+        }
+
+        // The Returner calls Return.
+        friend class Returner;
+
+        // Attributes ----------------------------------------------------------
+        // The recycled objects, newest last (LIFO keeps the hot object
+        // hot), and the lock guarding them.
+        std::vector< TYPE* > m_free;
+
+        std::mutex m_lock;
+
+        // Objects out under handles, and the Reserve floor.
+        std::atomic< int > m_inUse;
+
+        int m_reserved;
+    };
+}; // End of namespace wbs
+
+#endif // #ifndef _OBJECTPOOL_H_
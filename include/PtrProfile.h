@@ -0,0 +1,352 @@
+/**
+ * PtrProfile.h
+ *
+ * Abstract:
+ * Opt-in allocation-site profiling for the pointer classes.  Building
+ * with -DWBS_PTR_PROFILE makes UP's and SP's raw-pointer constructors
+ * capture the file and line that adopted the pointer, and aggregates
+ * per-site adoption/release counts and live high-water marks into a
+ * table PtrProfile::Dump() prints (or Snapshot() returns for tooling).
+ * MemCache allocations made while a PtrProfile::Scope is active are
+ * attributed to that scope's site, so a canary build can finally rank
+ * pointer-churn hotspots instead of guessing from allocator totals.
+ *
+ * Without the define this header contributes nothing and every hook in
+ * UP.h, SP.h, and MemCache.h compiles away - release builds pay zero.
+ *
+ * The site is captured with __builtin_FILE()/__builtin_LINE() default
+ * arguments (the pre-C++20 stand-in for std::source_location): a
+ * defaulted SiteArg parameter evaluates the builtins at the caller, so
+ * the table shows the adopting line, not this library's internals.
+ * Factory paths (MakeUP, MakeSP) adopt from inside the library and so
+ * aggregate under the factory's own line; wrap a hot region in a
+ * PtrProfile::Scope to re-attribute everything it adopts or allocates.
+ *
+ * @see UP.h SP.h MemCache.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _PTRPROFILE_H_
+#define _PTRPROFILE_H_
+
+#ifdef WBS_PTR_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    /**
+     * @class PtrProfile
+     *
+     * The profiling registry: a fixed, lock-free table of call sites plus
+     * a (mutex-guarded) map from live object addresses to their sites, so
+     * releases decrement the right site no matter which thread or pointer
+     * class performs them.  An address adopted a second time (e.g. a
+     * pointer re-wrapped after traveling through a PtrQueue) moves to the
+     * new site; its original site's live count drops as if released.
+     */
+    class PtrProfile
+    {
+        // Declared up front so Scope below can hold one; defined with the
+        // other private details at the bottom of the class.
+        struct Site;
+
+    public:
+        // Types ---------------------------------------------------------------
+        /**
+         * A call-site argument.  Take one as a defaulted trailing
+         * parameter and the builtins evaluate at YOUR caller, capturing
+         * its file and line.
+         */
+        struct SiteArg
+        {
+            SiteArg( const char* file = __builtin_FILE(),
+                     int line = __builtin_LINE() )
+            {
+                m_file = file;
+                m_line = line;
+            }
+
+            const char* m_file;
+            int         m_line;
+        };
+
+        /**
+         * One row of a Snapshot(): a site's aggregate counts.
+         */
+        struct SiteInfo
+        {
+            const char* m_file;
+            int         m_line;
+            long long   m_allocs;
+            long long   m_frees;
+            int         m_live;
+            int         m_highWater;
+        };
+
+        /**
+         * @class Scope
+         * RAII attribution override: while one is alive, everything the
+         * current thread adopts or MemCache-allocates is charged to the
+         * scope's construction site rather than the library-internal line
+         * that performed it.  Nests; the prior attribution is restored on
+         * destruction.
+         */
+        class Scope
+        {
+        public:
+            explicit Scope( SiteArg site = {} )
+            {
+                m_prior = sm_armed;
+                sm_armed = SiteFor( site.m_file, site.m_line );
+            }
+
+            ~Scope()
+            {
+                sm_armed = m_prior;
+            }
+
+        private:
+            Scope( const Scope& );
+            const Scope& operator=( const Scope& );
+
+            Site* m_prior;
+        };
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Records an ownership adoption of the passed object, attributed
+         * to the active Scope if any, else to the passed site.
+         *
+         * @param obj  - the adopted object's address.
+         * @param site - the adopting call site.
+         */
+        static void RecordAlloc( const void* obj, const SiteArg& site )
+        {
+            Site* slot = ( nullptr != sm_armed )
+                             ? sm_armed
+                             : SiteFor( site.m_file, site.m_line );
+
+            std::lock_guard< std::mutex > hold( MapMutex() );
+
+            auto existing = LiveMap().find( obj );
+            if ( LiveMap().end() != existing )
+            {
+                // Re-adoption: the address moves to the new site.
+                existing->second->m_live.fetch_sub(
+                    1, std::memory_order_relaxed );
+                existing->second = slot;
+            }
+            else
+            {
+                LiveMap()[ obj ] = slot;
+            }
+
+            slot->m_allocs.fetch_add( 1, std::memory_order_relaxed );
+            int live = slot->m_live.fetch_add(
+                           1, std::memory_order_relaxed ) + 1;
+            int high = slot->m_highWater.load( std::memory_order_relaxed );
+            while ( ( live > high ) &&
+                    !slot->m_highWater.compare_exchange_weak(
+                        high, live, std::memory_order_relaxed ) )
+            {
+            }
+        }
+
+        /**
+         * Records a MemCache block allocation.  Only attributed (and only
+         * counted) when a Scope is active on this thread; anonymous cache
+         * traffic would otherwise drown the table in unknowns.
+         *
+         * @param mem - the allocated block.
+         */
+        static void RecordArmedAlloc( const void* mem )
+        {
+            if ( nullptr != sm_armed )
+            {
+                RecordAlloc( mem, SiteArg( "<armed>", 0 ) );
+            }
+        }
+
+        /**
+         * Records the release of a previously recorded address.  Unknown
+         * addresses (never recorded, or already released through another
+         * hook) are ignored.
+         *
+         * @param obj - the released address.
+         */
+        static void RecordFree( const void* obj )
+        {
+            std::lock_guard< std::mutex > hold( MapMutex() );
+
+            auto entry = LiveMap().find( obj );
+            if ( LiveMap().end() != entry )
+            {
+                entry->second->m_frees.fetch_add(
+                    1, std::memory_order_relaxed );
+                entry->second->m_live.fetch_sub(
+                    1, std::memory_order_relaxed );
+                LiveMap().erase( entry );
+            }
+        }
+
+        /**
+         * Returns every known site's counts, sorted by live high-water
+         * mark (the canary question is "who holds the most at peak").
+         */
+        static std::vector< SiteInfo > Snapshot()
+        {
+            std::vector< SiteInfo > rows;
+            for ( int slot = 0; slot < MAX_SITES; ++slot )
+            {
+                const char* file =
+                    sm_sites[ slot ].m_file.load( std::memory_order_acquire );
+                if ( nullptr == file )
+                {
+                    continue;
+                }
+
+                SiteInfo row;
+                row.m_file = file;
+                row.m_line = sm_sites[ slot ].m_line;
+                row.m_allocs = sm_sites[ slot ].m_allocs.load(
+                    std::memory_order_relaxed );
+                row.m_frees = sm_sites[ slot ].m_frees.load(
+                    std::memory_order_relaxed );
+                row.m_live = sm_sites[ slot ].m_live.load(
+                    std::memory_order_relaxed );
+                row.m_highWater = sm_sites[ slot ].m_highWater.load(
+                    std::memory_order_relaxed );
+                rows.push_back( row );
+            }
+
+            std::sort( rows.begin(), rows.end(),
+                       []( const SiteInfo& a, const SiteInfo& b )
+            {
+                return a.m_highWater > b.m_highWater;
+            } );
+
+            return rows;
+        }
+
+        /**
+         * Prints the site table, hottest (by live high-water) first.
+         *
+         * @param out - the destination stream; defaults to stdout.
+         */
+        static void Dump( std::FILE* out = stdout )
+        {
+            std::fprintf( out, "%-48s %10s %10s %8s %10s\n",
+                          "site", "allocs", "frees", "live", "highwater" );
+            for ( const SiteInfo& row : Snapshot() )
+            {
+                char site[ 64 ];
+                std::snprintf( site, sizeof( site ), "%s:%d",
+                               row.m_file, row.m_line );
+                std::fprintf( out, "%-48s %10lld %10lld %8d %10d\n",
+                              site, row.m_allocs, row.m_frees,
+                              row.m_live, row.m_highWater );
+            }
+        }
+
+    private:
+        // Constants -----------------------------------------------------------
+        // The site table size.  Sites are never removed; a build with
+        // more distinct adoption sites than this lumps the excess into
+        // one overflow row.
+        static constexpr int MAX_SITES = 1024;
+
+        // Attributes ----------------------------------------------------------
+        // One site's counters.  m_file doubles as the claim flag: a slot
+        // is claimed by CAS-publishing the file pointer (line is written
+        // first, so a published slot is fully initialized).
+        struct Site
+        {
+            std::atomic< const char* > m_file = { nullptr };
+            int                        m_line = 0;
+            std::atomic< long long >   m_allocs = { 0 };
+            std::atomic< long long >   m_frees = { 0 };
+            std::atomic< int >         m_live = { 0 };
+            std::atomic< int >         m_highWater = { 0 };
+        };
+
+        // Methods -------------------------------------------------------------
+        // Finds (or claims) the table slot for a site.  File pointers are
+        // string literals, so identity comparison suffices.
+        static Site* SiteFor( const char* file, int line )
+        {
+            std::size_t probe =
+                ( ( reinterpret_cast< std::uintptr_t >( file ) >> 4 )
+                  * 31 + static_cast< std::size_t >( line ) )
+                % MAX_SITES;
+
+            for ( int step = 0; step < MAX_SITES; ++step )
+            {
+                Site& slot = sm_sites[ probe ];
+                const char* claimed =
+                    slot.m_file.load( std::memory_order_acquire );
+
+                if ( nullptr == claimed )
+                {
+                    slot.m_line = line;
+                    if ( slot.m_file.compare_exchange_strong(
+                             claimed, file, std::memory_order_release ) )
+                    {
+                        return &slot;
+                    }
+                    // Lost the claim; fall through to check the winner.
+                }
+                if ( ( claimed == file ) && ( slot.m_line == line ) )
+                {
+                    return &slot;
+                }
+
+                probe = ( probe + 1 ) % MAX_SITES;
+            }
+
+            // Table full: everything else aggregates here.
+            static Site overflow;
+            overflow.m_file.store( "<overflow>",
+                                   std::memory_order_relaxed );
+
+            return &overflow;
+        }
+
+        // The live-object map and its lock.  Function-local statics keep
+        // this header-only without ODR issues on the container.
+        static std::unordered_map< const void*, Site* >& LiveMap()
+        {
+            static std::unordered_map< const void*, Site* > map;
+            return map;
+        }
+
+        static std::mutex& MapMutex()
+        {
+            static std::mutex lock;
+            return lock;
+        }
+
+        // The site table (defined just below the class; an inline static
+        // member cannot be initialized in-class while Site's own default
+        // initializers are still incomplete), and the per-thread
+        // attribution override.
+        static Site sm_sites[ MAX_SITES ];
+
+        static inline thread_local Site* sm_armed = nullptr;
+    };
+
+    inline PtrProfile::Site PtrProfile::sm_sites[ PtrProfile::MAX_SITES ] = {};
+}; // End of namespace wbs
+
+#endif // #ifdef WBS_PTR_PROFILE
+
+#endif // #ifndef _PTRPROFILE_H_
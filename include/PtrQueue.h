@@ -0,0 +1,390 @@
+/**
+ * PtrQueue.h
+ *
+ * Abstract:
+ * A bounded lock-free queue that moves UP ownership between pipeline
+ * stages.  The queue stores the raw pointer only - Push releases it from
+ * the producer's UP and Pop rewraps it into the consumer's UP - so a
+ * handoff touches no locks and no reference counts.  In the single-
+ * producer/single-consumer configuration a transfer is one store and one
+ * load per pointer; the multi-producer/multi-consumer configuration pays
+ * one CAS per side.
+ *
+ * @see UP.h SP.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _PTRQUEUE_H_
+#define _PTRQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "UP.h"
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    /**
+     * Concurrency tags for PtrQueue.  SingleProducerSingleConsumer is the
+     * default: exactly one thread may Push and exactly one (other) thread
+     * may Pop.  MultiProducerMultiConsumer allows any number of threads
+     * on either side.
+     */
+    class SingleProducerSingleConsumer {};
+    class MultiProducerMultiConsumer {};
+
+    /**
+     * @class PtrQueue
+     *
+     * A bounded ring of owning pointers.  Push takes a UP by rvalue and,
+     * on success, the queue owns the object; on failure (queue full) the
+     * caller's UP still owns it.  Pop fills the passed UP on success and
+     * leaves it untouched on failure (queue empty).  Objects still queued
+     * when the queue is destroyed are deleted through the DELETER.
+     *
+     * @note The deleter travels by type, not by value: the consumer's UP
+     *       reconstructs a default DELETER, so stateful deleters cannot
+     *       ride through the queue.
+     */
+    template< typename TYPE,
+              typename CONCURRENCY = SingleProducerSingleConsumer,
+              typename DELETER = DefaultDelete >
+    class PtrQueue;
+
+    /**
+     * The single-producer/single-consumer configuration.  The producer
+     * owns m_tail, the consumer owns m_head, and each keeps a cached copy
+     * of the other's index so the full/empty checks only touch the shared
+     * counter when the cached value says the operation would fail.  Both
+     * hot counters sit on their own cache line.
+     */
+    template< typename TYPE, typename DELETER >
+    class PtrQueue< TYPE, SingleProducerSingleConsumer, DELETER >
+    {
+        static_assert( std::is_default_constructible< DELETER >::value,
+                       "PtrQueue requires a default-constructible deleter; "
+                       "deleter state cannot ride through the queue" );
+
+    public:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Constructs a queue holding at most the passed number of
+         * pointers (rounded up to a power of two for cheap indexing).
+         *
+         * @param capacity - the minimum number of in-flight pointers the
+         *                   queue must hold.
+         */
+        explicit PtrQueue( std::size_t capacity )
+        {
+            m_mask = RoundUpPow2( capacity ) - 1;
+            m_slots = ::new TYPE*[ m_mask + 1 ];
+        }
+
+        /**
+         * The Destructor.  Deletes (through the DELETER) any objects
+         * still in flight.  Must not race with Push or Pop.
+         */
+        ~PtrQueue()
+        {
+            UP< TYPE, DELETER > drain;
+            while ( Pop( drain ) )
+            {
+                drain.Delete();
+            }
+
+            ::delete[] m_slots;
+        }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Moves the passed UP's object into the queue.
+         *
+         * @param item - the UP to transfer from.  Emptied on success;
+         *               untouched (still owning) on failure.
+         *
+         * @return true if the object was queued, false if the queue is
+         *         full.
+         */
+        bool Push( UP< TYPE, DELETER >&& item )
+        {
+            std::size_t tail = m_tail.load( std::memory_order_relaxed );
+            if ( ( tail - m_cachedHead ) > m_mask )
+            {
+                m_cachedHead = m_head.load( std::memory_order_acquire );
+                if ( ( tail - m_cachedHead ) > m_mask )
+                {
+                    return false;
+                }
+            }
+
+            m_slots[ tail & m_mask ] = item.UnsafeRelease();
+            m_tail.store( tail + 1, std::memory_order_release );
+
+            return true;
+        }
+
+        /**
+         * Moves the oldest queued object into the passed UP.
+         *
+         * @param item - the UP to transfer into.  Its previous object (if
+         *               any) is deleted first, exactly as UP move
+         *               assignment would.
+         *
+         * @return true if an object was dequeued, false if the queue is
+         *         empty.
+         */
+        bool Pop( UP< TYPE, DELETER >& item )
+        {
+            std::size_t head = m_head.load( std::memory_order_relaxed );
+            if ( head == m_cachedTail )
+            {
+                m_cachedTail = m_tail.load( std::memory_order_acquire );
+                if ( head == m_cachedTail )
+                {
+                    return false;
+                }
+            }
+
+            item = UP< TYPE, DELETER >( m_slots[ head & m_mask ] );
+            m_head.store( head + 1, std::memory_order_release );
+
+            return true;
+        }
+
+    private:
+        // Constructors, destructor, and Assignment operator -------------------
+        // A queue owns its in-flight objects outright; copying one is
+        // meaningless.
+        PtrQueue( const PtrQueue& );
+        const PtrQueue& operator=( const PtrQueue& );
+
+        // Methods -------------------------------------------------------------
+        // Rounds up to the next power of two (minimum 2, so head and tail
+        // can always tell full from empty).
+        static std::size_t RoundUpPow2( std::size_t value )
+        {
+            std::size_t pow2 = 2;
+            while ( pow2 < value )
+            {
+                pow2 <<= 1;
+            }
+
+            return pow2;
+        }
+
+        // Attributes ----------------------------------------------------------
+        // The ring and its index mask (capacity - 1).
+        TYPE**      m_slots;
+        std::size_t m_mask;
+
+        // The consumer's line: its own index plus its cached view of the
+        // producer's.
+        alignas( 64 ) std::atomic< std::size_t > m_head = { 0 };
+        std::size_t m_cachedTail = 0;
+
+        // The producer's line, likewise.
+        alignas( 64 ) std::atomic< std::size_t > m_tail = { 0 };
+        std::size_t m_cachedHead = 0;
+    };
+
+    /**
+     * The multi-producer/multi-consumer configuration: a bounded ring
+     * where every slot carries a sequence number that tells an arriving
+     * producer or consumer whether the slot is ready for it.  Each side
+     * claims a slot with one CAS on its ticket counter and then completes
+     * the transfer with plain stores - no thread ever waits on another's
+     * half-finished operation.
+     */
+    template< typename TYPE, typename DELETER >
+    class PtrQueue< TYPE, MultiProducerMultiConsumer, DELETER >
+    {
+        static_assert( std::is_default_constructible< DELETER >::value,
+                       "PtrQueue requires a default-constructible deleter; "
+                       "deleter state cannot ride through the queue" );
+
+    public:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Constructs a queue holding at most the passed number of
+         * pointers (rounded up to a power of two for cheap indexing).
+         *
+         * @param capacity - the minimum number of in-flight pointers the
+         *                   queue must hold.
+         */
+        explicit PtrQueue( std::size_t capacity )
+        {
+            m_mask = RoundUpPow2( capacity ) - 1;
+            m_slots = ::new Slot[ m_mask + 1 ];
+            for ( std::size_t slot = 0; slot <= m_mask; ++slot )
+            {
+                m_slots[ slot ].m_sequence.store(
+                    slot, std::memory_order_relaxed );
+            }
+        }
+
+        /**
+         * The Destructor.  Deletes (through the DELETER) any objects
+         * still in flight.  Must not race with Push or Pop.
+         */
+        ~PtrQueue()
+        {
+            UP< TYPE, DELETER > drain;
+            while ( Pop( drain ) )
+            {
+                drain.Delete();
+            }
+
+            ::delete[] m_slots;
+        }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Moves the passed UP's object into the queue.
+         *
+         * @param item - the UP to transfer from.  Emptied on success;
+         *               untouched (still owning) on failure.
+         *
+         * @return true if the object was queued, false if the queue is
+         *         full.
+         */
+        bool Push( UP< TYPE, DELETER >&& item )
+        {
+            std::size_t ticket =
+                m_pushTicket.load( std::memory_order_relaxed );
+
+            for ( ;; )
+            {
+                Slot& slot = m_slots[ ticket & m_mask ];
+                std::size_t sequence =
+                    slot.m_sequence.load( std::memory_order_acquire );
+
+                if ( sequence == ticket )
+                {
+                    // The slot is empty and it's our turn; claim the
+                    // ticket and fill it.
+                    if ( m_pushTicket.compare_exchange_weak(
+                             ticket, ticket + 1,
+                             std::memory_order_relaxed ) )
+                    {
+                        slot.m_value = item.UnsafeRelease();
+                        slot.m_sequence.store(
+                            ticket + 1, std::memory_order_release );
+
+                        return true;
+                    }
+                }
+                else if ( sequence < ticket )
+                {
+                    // The slot still holds the value from a full lap ago:
+                    // the queue is full.
+                    return false;
+                }
+                else
+                {
+                    // Another producer beat us to this ticket; take the
+                    // next one.
+                    ticket = m_pushTicket.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+        /**
+         * Moves the oldest queued object into the passed UP.
+         *
+         * @param item - the UP to transfer into.  Its previous object (if
+         *               any) is deleted first, exactly as UP move
+         *               assignment would.
+         *
+         * @return true if an object was dequeued, false if the queue is
+         *         empty.
+         */
+        bool Pop( UP< TYPE, DELETER >& item )
+        {
+            std::size_t ticket =
+                m_popTicket.load( std::memory_order_relaxed );
+
+            for ( ;; )
+            {
+                Slot& slot = m_slots[ ticket & m_mask ];
+                std::size_t sequence =
+                    slot.m_sequence.load( std::memory_order_acquire );
+
+                if ( sequence == ( ticket + 1 ) )
+                {
+                    // The slot holds our value; claim the ticket and take
+                    // it.
+                    if ( m_popTicket.compare_exchange_weak(
+                             ticket, ticket + 1,
+                             std::memory_order_relaxed ) )
+                    {
+                        item = UP< TYPE, DELETER >( slot.m_value );
+                        slot.m_sequence.store(
+                            ticket + m_mask + 1,
+                            std::memory_order_release );
+
+                        return true;
+                    }
+                }
+                else if ( sequence < ( ticket + 1 ) )
+                {
+                    // The producer for this slot hasn't arrived: the
+                    // queue is empty.
+                    return false;
+                }
+                else
+                {
+                    // Another consumer beat us to this ticket; take the
+                    // next one.
+                    ticket = m_popTicket.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+    private:
+        // Constructors, destructor, and Assignment operator -------------------
+        // A queue owns its in-flight objects outright; copying one is
+        // meaningless.
+        PtrQueue( const PtrQueue& );
+        const PtrQueue& operator=( const PtrQueue& );
+
+        // Methods -------------------------------------------------------------
+        // Rounds up to the next power of two (minimum 2, so the sequence
+        // arithmetic can always tell full from empty).
+        static std::size_t RoundUpPow2( std::size_t value )
+        {
+            std::size_t pow2 = 2;
+            while ( pow2 < value )
+            {
+                pow2 <<= 1;
+            }
+
+            return pow2;
+        }
+
+        // Attributes ----------------------------------------------------------
+        // One ring slot: the sequence number says whose turn the slot is
+        // (equal to the push ticket when empty, push ticket + 1 when
+        // full).  Each slot gets its own cache line so neighboring slots
+        // don't false-share under load.
+        struct alignas( 64 ) Slot
+        {
+            std::atomic< std::size_t > m_sequence;
+            TYPE*                      m_value;
+        };
+
+        // The ring and its index mask (capacity - 1).
+        Slot*       m_slots;
+        std::size_t m_mask;
+
+        // The producers' and consumers' ticket counters, each on its own
+        // cache line.
+        alignas( 64 ) std::atomic< std::size_t > m_pushTicket = { 0 };
+        alignas( 64 ) std::atomic< std::size_t > m_popTicket = { 0 };
+    };
+}; // End of namespace wbs
+
+#endif // #ifndef _PTRQUEUE_H_
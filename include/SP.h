@@ -19,8 +19,14 @@
 #ifndef _SP_H_
 #define _SP_H_
 
-#include <mutex>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "Epoch.h"
 #include "UP.h"
 #include "MemCache.h"
 
@@ -30,8 +36,709 @@
  */
 namespace wbs
 {
-    // Forward declare the Weak Pointer type to make it a friend below.
-    template < typename TYPEWP > class WP;
+    /**
+     * Threading policies for SP (and WP).  Selected at compile time via the
+     * second template parameter, e.g. SP< Foo, wbs::SingleThreaded >.
+     *
+     * MultiThreaded (the default) keeps the reference counts in an atomic
+     * word, so SPs may be copied and destroyed freely across threads.
+     *
+     * SingleThreaded uses plain integer arithmetic with no fences and no
+     * atomics - a copy is a pointer copy plus an ordinary increment.  All
+     * SPs and WPs sharing one object must then live on a single thread; use
+     * it for per-request object graphs that never cross threads.
+     *
+     * BiasedThreaded sits between the two: the thread that creates the
+     * object keeps a fast unsynchronized count of its own references, while
+     * foreign threads share the usual atomic count.  Copies on the owning
+     * thread then cost one ordinary increment, yet the object may still be
+     * shared with other threads - the occasional cross-thread copy simply
+     * pays the atomic price.  When the owner releases its last reference
+     * the biased count is merged into the shared one, and the last
+     * reference overall (on whichever thread) destroys the object.
+     *
+     * The biased contract: a reference taken on the owning thread must be
+     * RELEASED on the owning thread, because only the owner may touch the
+     * unsynchronized count.  Copies made on other threads are counted
+     * atomically and may be released anywhere; what must not happen is
+     * MOVING an SP from the owner to another thread for destruction there
+     * (hand a copy across instead, or use a PtrQueue of UPs for true
+     * ownership handoff).  Intrusive (RefCounted) classes and deferred
+     * reclamation keep the fully atomic MultiThreaded behavior under this
+     * policy.
+     */
+    struct MultiThreaded {};
+    struct SingleThreaded {};
+    struct BiasedThreaded {};
+
+    // Forward declare the Weak Pointer type to make it a friend below.  WP
+    // honors the same threading policy as the SP it tracks.
+    template < typename TYPEWP, typename POLICYWP = MultiThreaded > class WP;
+
+    // Forward declare the count block so the deferred-reclamation queue can
+    // hold a list of them.
+    template < typename POLICY > class ControlBlock;
+
+    /**
+     * @class DeferredReclaim
+     * Opt-in deferred destruction for shared objects.  Normally the thread
+     * that drops the last SP reference runs the object's destructor and
+     * deallocation inline - which, for a large object graph, can be a
+     * latency spike on whatever request thread happened to be last out.
+     *
+     * When enabled, the final DecRef instead pushes the doomed object's
+     * count block onto a process-wide lock-free list (a single CAS) and
+     * returns immediately.  The actual teardown happens when someone pumps
+     * DrainDeferred() - from a housekeeping point in the application's
+     * loop, or from a thread dedicated to it.
+     *
+     * Only MultiThreaded-policy pointers participate: SingleThreaded object
+     * graphs live and die on one thread, where handing teardown to another
+     * thread would be wrong by definition.
+     *
+     * @note While an object sits on the list it is dead to the rest of the
+     *       process: its strong count is zero, so WP promotion fails and
+     *       Expired() reports true.  Only the destructor is late, never the
+     *       answer to "is it alive".
+     * @note Disable() stops new deferrals but does not drain; pump
+     *       DrainDeferred() (after the deferring threads quiesce) to
+     *       reclaim anything still queued.
+     */
+    class DeferredReclaim
+    {
+    public:
+        // Turns deferral on/off for all MultiThreaded SPs in the process.
+        static void Enable()
+        {
+            sm_enabled.store( true, std::memory_order_relaxed );
+        }
+
+        static void Disable()
+        {
+            sm_enabled.store( false, std::memory_order_relaxed );
+        }
+
+        static bool Enabled()
+        {
+            return sm_enabled.load( std::memory_order_relaxed );
+        }
+
+        // Destroys everything queued so far.  Returns the number of objects
+        // reclaimed, so a pumping loop can tell when it has caught up.
+        static std::size_t Drain();
+
+    private:
+        // Only the count block itself may queue.
+        template < typename POLICY > friend class ControlBlock;
+
+        static void Push( ControlBlock< MultiThreaded >* block );
+
+        // Whether final DecRefs defer.  Checked on every last-reference
+        // drop, hence relaxed: a racing Enable/Disable just means that one
+        // object goes to whichever side of the switch it caught.
+        static inline std::atomic< bool > sm_enabled{ false };
+
+        // The lock-free list of doomed blocks, linked through their
+        // m_deferNext members.  Push is a CAS on the head; Drain exchanges
+        // the whole list out at once, so no ABA window exists.
+        static inline std::atomic< ControlBlock< MultiThreaded >* >
+            sm_head{ nullptr };
+    };
+
+    // Forward declare the single-allocation factory so it can be made a
+    // friend of SP below.  See the definition at the bottom of this file.
+    template < typename TYPESP, typename POLICY = MultiThreaded,
+               typename... ARGS >
+    SP< TYPESP, POLICY > MakeSP( ARGS&&... args );
+
+    // Forward declare the bulk span operations so they can be made friends
+    // of SP below.  See the definitions at the bottom of this file.
+    template< typename TYPESP, typename POLICY >
+    void CopySpan( SP< TYPESP, POLICY >* dst,
+                   const SP< TYPESP, POLICY >* src,
+                   std::size_t count );
+
+    template< typename TYPESP, typename POLICY >
+    void ReleaseSpan( SP< TYPESP, POLICY >* span, std::size_t count );
+
+    /**
+     * @class RefCounted
+     * CRTP base that embeds the reference count in the object itself.  When
+     * a class inherits RefCounted< itself >, SP detects it and stores just
+     * the object pointer: no separate InternalObject is ever allocated, and
+     * operator-> loses a level of indirection since the count sits inside
+     * the object (on the same cache line as its hot fields, if placed
+     * first).
+     *
+     * Usage: class Foo : public wbs::RefCounted< Foo > { ... };
+     *        SP< Foo > p( new Foo );
+     *
+     * The count starts at zero and each SP that adopts a raw pointer
+     * increments it, so - unlike the external-control-block mode - wrapping
+     * the same raw pointer in two SPs is safe.  Weak pointers are NOT
+     * supported in intrusive mode: the count dies with the object, so there
+     * is nothing left for a WP to interrogate (WP enforces this at compile
+     * time).  The POLICY parameter matches the policy of the SPs used with
+     * the class.
+     *
+     * @note Objects of the inheriting class must be heap-allocated when
+     *       managed by SPs, as the last SP deletes the object.
+     */
+    template< typename TYPERC, typename POLICY = MultiThreaded >
+    class RefCounted
+    {
+    public:
+        // Increments the reference count, by more than one when the caller
+        // has coalesced several references (see CopySpan).  See SP's
+        // InternalObject for the reasoning behind the memory orders used
+        // here and in DecRef.
+        void AddRef( std::uint32_t count = 1 )
+        {
+            if constexpr ( SINGLE_THREADED )
+            {
+                m_refCount += count;
+            }
+            else
+            {
+                m_refCount.fetch_add( count, std::memory_order_relaxed );
+            }
+        }
+
+        // Decrements the reference count (by more than one when coalesced;
+        // see ReleaseSpan), deleting the object (through its own operator
+        // delete, as always) when the count hits zero.
+        void DecRef( std::uint32_t count = 1 )
+        {
+            std::uint64_t prior;
+            if constexpr ( SINGLE_THREADED )
+            {
+                prior = m_refCount;
+                m_refCount -= count;
+            }
+            else
+            {
+                prior = m_refCount.fetch_sub( count,
+                                              std::memory_order_acq_rel );
+            }
+
+            if ( count == prior )
+            {
+#ifdef WBS_PTR_PROFILE
+                PtrProfile::RecordFree( static_cast< TYPERC* >( this ) );
+#endif
+#ifdef WBS_TP_VALIDATE
+                TPValidate::OnDestroy( static_cast< TYPERC* >( this ) );
+#endif
+                delete static_cast< TYPERC* >( this );
+            }
+        }
+
+        // The current number of referencing SPs, matching the accessor the
+        // external control block provides (see ControlBlock::StrongCount)
+        // so SP::UseCount works in either mode.
+        std::uint32_t StrongCount() const
+        {
+            if constexpr ( SINGLE_THREADED )
+            {
+                return static_cast< std::uint32_t >( m_refCount );
+            }
+            else
+            {
+                return static_cast< std::uint32_t >(
+                    m_refCount.load( std::memory_order_relaxed ) );
+            }
+        }
+
+    protected:
+        // Constructors, destructor, and Assignment operator -------------------
+        // Only the inheriting class constructs/destroys this base.  Copies
+        // of the object deliberately do NOT copy the count: the new object
+        // has its own (empty) set of referencing SPs.
+        RefCounted()
+        : m_refCount( 0 )
+        {
+        }
+
+        RefCounted( const RefCounted& )
+        : m_refCount( 0 )
+        {
+        }
+
+        RefCounted& operator=( const RefCounted& )
+        {
+            return *this;
+        }
+
+        ~RefCounted() = default;
+
+    private:
+        // True when the SingleThreaded policy was selected (see SP.h).
+        static constexpr bool SINGLE_THREADED =
+            std::is_same_v< POLICY, SingleThreaded >;
+
+        // The embedded reference count.  No weak count exists in intrusive
+        // mode.
+        std::conditional_t< SINGLE_THREADED,
+                            std::uint64_t,
+                            std::atomic< std::uint64_t > > m_refCount;
+    };
+
+    /**
+     * Helper traits that detect whether a class provides its own operator
+     * new/delete overloads.  The single-allocation MakeSP path uses these to
+     * route the combined control-block-plus-object allocation through the
+     * class's own allocator (e.g. a MemCache) when one exists, preserving the
+     * project's principle that allocation behavior belongs to the class.
+     */
+    template< typename T, typename = void >
+    struct HasClassNew : std::false_type {};
+    template< typename T >
+    struct HasClassNew< T,
+        std::void_t< decltype( T::operator new( std::size_t( 0 ) ) ) > >
+    : std::true_type {};
+
+    // Detects a class-provided unsized operator delete( void* ).
+    template< typename T, typename = void >
+    struct HasClassDelete : std::false_type {};
+    template< typename T >
+    struct HasClassDelete< T,
+        std::void_t< decltype( T::operator delete( static_cast< void* >( nullptr ) ) ) > >
+    : std::true_type {};
+
+    // Detects a class-provided sized operator delete( void*, size_t ).
+    template< typename T, typename = void >
+    struct HasClassSizedDelete : std::false_type {};
+    template< typename T >
+    struct HasClassSizedDelete< T,
+        std::void_t< decltype( T::operator delete( static_cast< void* >( nullptr ),
+                                                   std::size_t( 0 ) ) ) > >
+    : std::true_type {};
+
+    /**
+     * @class BiasState
+     * The per-policy slice of ControlBlock that exists only under the
+     * BiasedThreaded policy: the identity of the owning thread and its
+     * unsynchronized reference count.  For the other policies this base is
+     * empty and the empty-base optimization makes it free, so non-biased
+     * control blocks are exactly the size they were.
+     */
+    template< typename POLICY >
+    class BiasState
+    {
+    protected:
+        // Non-biased policies carry no bias state.
+    };
+
+    template<>
+    class BiasState< BiasedThreaded >
+    {
+    protected:
+        // The constructing thread is the owner, and it holds the first
+        // reference in its unsynchronized count.
+        BiasState()
+        : m_ownerThread( std::this_thread::get_id() ),
+          m_localStrong( 1 )
+        {
+        }
+
+        // Whether the calling thread may use the unsynchronized count: it
+        // must be the owner, and the bias must not have been merged away
+        // yet.  The thread-id check comes first so no other thread ever
+        // reads the unsynchronized count.
+        bool OwnsBias() const
+        {
+            return ( std::this_thread::get_id() == m_ownerThread )
+                   && ( 0 != m_localStrong );
+        }
+
+        // The thread that created the block.  Written once at construction
+        // and read-only thereafter, so publishing the SP to another thread
+        // publishes this too.
+        std::thread::id m_ownerThread;
+
+        // The owner's references, counted with no atomics at all.  While
+        // this is non-zero the shared count holds one stub reference on its
+        // behalf; when it reaches zero the owner releases the stub (the
+        // merge) and all further traffic - even the owner's - is atomic.
+        std::uint64_t m_localStrong;
+    };
+
+    /**
+     * @class ControlBlock
+     * The type-erased base of SP's InternalObject.  The packed reference
+     * counts and their manipulation live here, while everything that depends
+     * on the managed object's type (destroying the object, freeing the
+     * block) is reached through virtual hooks implemented by the derived
+     * InternalObject.
+     *
+     * The erasure is what makes the aliasing constructor possible: an
+     * SP< MEMBER > can share the count block of an SP< OWNER > - two
+     * different InternalObject instantiations - because both SPs only ever
+     * talk to this common base.  It is an implementation detail of SP/WP
+     * and should not be used directly.
+     */
+    template< typename POLICY >
+    class ControlBlock : private BiasState< POLICY >
+    {
+    public:
+        // Increments the reference count, by more than one when the caller
+        // has coalesced several references to this block (see CopySpan).
+        void AddRef( std::uint32_t count = 1 )
+        {
+            // Under the BiasedThreaded policy the owning thread counts its
+            // references with plain arithmetic for as long as it holds the
+            // bias; everyone else (and the owner, once the bias has been
+            // merged away) falls through to the atomic word.
+            if constexpr ( BIASED )
+            {
+                if ( this->OwnsBias() )
+                {
+                    this->m_localStrong += count;
+                    return;
+                }
+            }
+
+            // A plain increment of the strong half of the packed word.
+            // For the MultiThreaded policy this is atomic; relaxed
+            // ordering is sufficient since the caller already holds a
+            // reference, so the count cannot concurrently reach zero,
+            // and no other data is published by this operation.  The
+            // SingleThreaded policy uses ordinary arithmetic.
+            if constexpr ( SINGLE_THREADED )
+            {
+                m_counts += STRONG_ONE * count;
+            }
+            else
+            {
+                m_counts.fetch_add( STRONG_ONE * count,
+                                    std::memory_order_relaxed );
+            }
+        }
+
+        // Decrement the reference count (by more than one when the caller
+        // has coalesced several releases; see ReleaseSpan), and if the
+        // refCount is then zero, destroy the object we track.  The shared
+        // references' implicit weak reference is then released, which
+        // destroys this block if no weak pointers remain either.
+        void DecRef( std::uint32_t count = 1 )
+        {
+            // The biased owner's releases are plain arithmetic too.  The
+            // shared count holds one stub reference on behalf of the whole
+            // biased count, so while any owner reference remains nothing
+            // more need happen; when the last one goes, the owner merges by
+            // releasing that stub through the atomic path below.  A
+            // coalesced release (see ReleaseSpan) may cover owner-counted
+            // and foreign-counted references in one call, so only up to
+            // m_localStrong of the count comes out of the unsynchronized
+            // tally; any remainder - plus the stub, when the owner's last
+            // local reference goes with it - falls through to the atomic
+            // word.
+            if constexpr ( BIASED )
+            {
+                if ( this->OwnsBias() )
+                {
+                    std::uint64_t localPart =
+                        ( count < this->m_localStrong )
+                            ? count
+                            : this->m_localStrong;
+                    this->m_localStrong -= localPart;
+                    count -= static_cast< std::uint32_t >( localPart );
+                    if ( 0 == this->m_localStrong )
+                    {
+                        ++count;
+                    }
+                    if ( 0 == count )
+                    {
+                        return;
+                    }
+                }
+            }
+
+            // Release ordering makes all of this thread's accesses to the
+            // object visible before the count drops; the acquire half
+            // (applied on the decrement that hits zero) makes those
+            // accesses visible to the deleting thread.  None of that is
+            // needed for the SingleThreaded policy.
+            std::uint64_t prior;
+            if constexpr ( SINGLE_THREADED )
+            {
+                prior = m_counts;
+                m_counts -= STRONG_ONE * count;
+            }
+            else
+            {
+                prior = m_counts.fetch_sub( STRONG_ONE * count,
+                                            std::memory_order_acq_rel );
+            }
+            if ( count == ( prior & STRONG_MASK ) )
+            {
+                // We took the last shared reference.  If deferred
+                // reclamation is on, hand the teardown to the drain
+                // instead of paying for it on this thread.  The strong
+                // count is already zero, so the object is unreachable
+                // (promotion fails) even while it waits.  Only the
+                // MultiThreaded policy defers (the drain queue holds that
+                // instantiation's blocks).
+                if constexpr ( !SINGLE_THREADED && !BIASED )
+                {
+                    if ( DeferredReclaim::Enabled() )
+                    {
+                        DeferredReclaim::Push( this );
+                        return;
+                    }
+                }
+
+                // Destroy the referenced object (how depends on the
+                // derived class)...
+                DisposeObject();
+
+                // ...and release the implicit weak reference held on
+                // behalf of all the shared pointers.  If no weak pointers
+                // remain, this deletes the block.  Any weak pointer that
+                // does remain keeps the block alive, and the last of them
+                // triggers the delete instead.
+                DecWeakRef();
+            }
+        }
+
+        // Increments the weak reference count.
+        void AddWeakRef()
+        {
+            // Relaxed is sufficient for the same reason as AddRef: the
+            // caller holds a (weak or shared) reference already.
+            if constexpr ( SINGLE_THREADED )
+            {
+                m_counts += WEAK_ONE;
+            }
+            else
+            {
+                m_counts.fetch_add( WEAK_ONE, std::memory_order_relaxed );
+            }
+        }
+
+        // Decrement the weak reference count, and self-destroy if this was
+        // the last weak reference.  Because the shared pointers hold one
+        // implicit weak reference between them (released in DecRef), the
+        // weak count only reaches zero once the shared count already has.
+        void DecWeakRef()
+        {
+            std::uint64_t prior;
+            if constexpr ( SINGLE_THREADED )
+            {
+                prior = m_counts;
+                m_counts -= WEAK_ONE;
+            }
+            else
+            {
+                prior = m_counts.fetch_sub( WEAK_ONE,
+                                            std::memory_order_acq_rel );
+            }
+            if ( 1 == ( ( prior >> WEAK_SHIFT ) & WEAK_COUNT_MASK ) )
+            {
+                // Zero references of either kind means we delete
+                // ourselves.  Nothing can be pointing at this block
+                // anymore, so no lock or fence is needed beyond the
+                // acquire above.
+                DestroySelf();
+            }
+        }
+
+        // Increments the reference count only if the object still exists
+        // (strong count non-zero), as a single lock-free operation.  This is
+        // what makes weak-pointer promotion race-free: a plain check
+        // followed by AddRef could interleave with a concurrent final
+        // DecRef, resurrecting an object mid-destruction.
+        //
+        // Returns true if the reference was taken, false if the object is
+        // already gone (or going).
+        //
+        // Promotion is always counted in the shared word - even on a
+        // BiasedThreaded owner's thread - so the promoted SP may be
+        // released anywhere.  The bias stub keeps the word non-zero while
+        // the owner holds references, so liveness reads correctly here.
+        bool TryAddRef()
+        {
+            if constexpr ( SINGLE_THREADED )
+            {
+                // No concurrency to defend against; just the check.
+                if ( 0 == ( m_counts & STRONG_MASK ) )
+                {
+                    return false;
+                }
+                m_counts += STRONG_ONE;
+                return true;
+            }
+            else
+            {
+                // The usual increment-if-not-zero CAS loop.  Acquire on
+                // success orders the object's contents after the point we
+                // claimed the reference; relaxed is fine on failure since
+                // we publish nothing.
+                std::uint64_t current =
+                    m_counts.load( std::memory_order_relaxed );
+                do
+                {
+                    if ( 0 == ( current & STRONG_MASK ) )
+                    {
+                        return false;
+                    }
+                } while ( !m_counts.compare_exchange_weak(
+                              current, current + STRONG_ONE,
+                              std::memory_order_acquire,
+                              std::memory_order_relaxed ) );
+                return true;
+            }
+        }
+
+        // The current number of shared references.  Used by WP to decide
+        // whether the tracked object still exists.  Under BiasedThreaded
+        // the owner's references appear here only as the single bias stub,
+        // so treat this as alive/dead, not an exact count.
+        std::uint32_t StrongCount() const
+        {
+            if constexpr ( SINGLE_THREADED )
+            {
+                return static_cast< std::uint32_t >( m_counts & STRONG_MASK );
+            }
+            else
+            {
+                return static_cast< std::uint32_t >(
+                    m_counts.load( std::memory_order_relaxed ) & STRONG_MASK );
+            }
+        }
+
+    protected:
+        // Constructors, destructor, and Assignment operator -------------------
+        // Only the derived InternalObject constructs this base, seeding the
+        // packed count word (see the constants below).
+        ControlBlock( std::uint64_t initialCounts )
+        : m_counts( initialCounts )
+        {
+        }
+
+        virtual ~ControlBlock() = default;
+
+        // Whether this block and its object share one allocation (the
+        // MakeSP layout).  The flag is set at construction and never
+        // changes, so a relaxed read suffices.
+        bool IsCombined() const
+        {
+            if constexpr ( SINGLE_THREADED )
+            {
+                return ( 0 != ( m_counts & COMBINED_FLAG ) );
+            }
+            else
+            {
+                return ( 0 != ( m_counts.load( std::memory_order_relaxed )
+                                & COMBINED_FLAG ) );
+            }
+        }
+
+        // Constants -----------------------------------------------------------
+        // Both counts are packed into one 64-bit word: the strong count in
+        // the low 32 bits and the weak count in the high 31 bits, with
+        // the top bit reserved to flag a combined (MakeSP) allocation.
+        // This lets a single fetch-add/fetch-sub manipulate either count.
+        // 2^32 - 1 (or 2^31 - 1 weak) references is far beyond anything a
+        // real process will hold.
+        static constexpr std::uint64_t STRONG_ONE      = 1;
+        static constexpr std::uint64_t STRONG_MASK     = 0xFFFFFFFF;
+        static constexpr int           WEAK_SHIFT      = 32;
+        static constexpr std::uint64_t WEAK_ONE        = 1ull << WEAK_SHIFT;
+        static constexpr std::uint64_t WEAK_COUNT_MASK = 0x7FFFFFFF;
+        static constexpr std::uint64_t COMBINED_FLAG   = 1ull << 63;
+
+        // True when the SingleThreaded policy was selected, in which case
+        // the packed count word is a plain integer with no fences at all.
+        static constexpr bool SINGLE_THREADED =
+            std::is_same_v< POLICY, SingleThreaded >;
+
+        // True when the BiasedThreaded policy was selected: the packed
+        // count word stays atomic (it carries the foreign references, the
+        // bias stub, and the weak count), and the owning thread's
+        // references live in the BiasState base.
+        static constexpr bool BIASED =
+            std::is_same_v< POLICY, BiasedThreaded >;
+
+    private:
+        // The deferred-reclamation drain runs DisposeObject/DecWeakRef on
+        // queued blocks and links them through m_deferNext.
+        friend class DeferredReclaim;
+
+        // The type-dependent halves of destruction, supplied by the derived
+        // InternalObject: destroy the managed object (last strong
+        // reference), and free this block itself (last weak reference).
+        virtual void DisposeObject() = 0;
+        virtual void DestroySelf() = 0;
+
+        // The link used while this block sits on the deferred-reclamation
+        // list.  Written by the deferring thread before the publishing CAS
+        // and read by the drainer after its acquire, so it needs no
+        // atomicity of its own.
+        ControlBlock* m_deferNext = nullptr;
+
+        // Attributes ----------------------------------------------------------
+        // The packed reference counts (see the constants above).  When the
+        // strong half goes to zero the referenced object is destroyed and
+        // the implicit weak reference is released; when the weak half goes
+        // to zero, this block deletes itself.  The word is atomic under the
+        // MultiThreaded policy and a plain integer under SingleThreaded.
+        std::conditional_t< SINGLE_THREADED,
+                            std::uint64_t,
+                            std::atomic< std::uint64_t > > m_counts;
+    };
+
+    // DeferredReclaim methods that need the complete ControlBlock ------------
+    // Queues a block whose strong count just hit zero.  A single CAS; the
+    // release pairs with Drain's acquire to publish the block's contents
+    // (and the link written just above) to the draining thread.
+    inline void DeferredReclaim::Push( ControlBlock< MultiThreaded >* block )
+    {
+        block->m_deferNext = sm_head.load( std::memory_order_relaxed );
+        while ( !sm_head.compare_exchange_weak( block->m_deferNext, block,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed ) )
+        {
+        }
+    }
+
+    inline std::size_t DeferredReclaim::Drain()
+    {
+        // Take the whole list in one exchange; new deferrals start a fresh
+        // list and wait for the next drain.
+        ControlBlock< MultiThreaded >* block =
+            sm_head.exchange( nullptr, std::memory_order_acquire );
+
+        std::size_t count = 0;
+        while ( nullptr != block )
+        {
+            // Grab the link first: releasing the implicit weak reference
+            // below may free the block.
+            ControlBlock< MultiThreaded >* next = block->m_deferNext;
+
+            // The teardown the final DecRef skipped: destroy the object,
+            // then release the shared pointers' implicit weak reference.
+            block->DisposeObject();
+            block->DecWeakRef();
+
+            block = next;
+            ++count;
+        }
+
+        return count;
+    }
+
+    /**
+     * Destroys all objects currently awaiting deferred reclamation (see
+     * DeferredReclaim).  Call this from a housekeeping point in the
+     * application's loop, or loop on it from a thread dedicated to cleanup.
+     *
+     * @return The number of objects reclaimed by this call.
+     */
+    inline std::size_t DrainDeferred()
+    {
+        return DeferredReclaim::Drain();
+    }
 
     /**
      * @class SP
@@ -41,53 +748,790 @@ namespace wbs
      * around with multiple copies of the original SP<>, and this code will keep
      * track of the number of copies so that when the final one is destructed,
      * the memory is freed.
+     *
+     * The POLICY parameter selects the threading policy (see MultiThreaded /
+     * SingleThreaded above) and defaults to the fully thread-safe behavior.
+     */
+    template< typename TYPESP, typename POLICY = MultiThreaded > class SP
+    {
+    public:
+        // True when TYPESP embeds its own reference count by inheriting
+        // RefCounted< TYPESP >.  In that mode no separate InternalObject is
+        // allocated; the SP stores the object pointer itself.
+        static constexpr bool IS_INTRUSIVE =
+            std::is_base_of_v< RefCounted< TYPESP, POLICY >, TYPESP >;
+
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * The Default Constructor.
+         */
+        SP()
+        {
+            m_internalObject = nullptr;
+            m_objectPtr = nullptr;
+        }
+
+        /**
+         * A constructor from a c-style raw pointer.  This takes ownership from
+         * the passed raw pointer and handles destroying the passed object.
+         *
+         * @param p - The c-style raw pointer whose object will be managed by
+         *            this SP.
+         *
+         * @note In a WBS_PTR_PROFILE build this adoption is recorded
+         *       against the calling file and line (see PtrProfile.h).
+         */
+#ifdef WBS_PTR_PROFILE
+        SP( TYPESP* p, PtrProfile::SiteArg site = {} )
+#else
+        SP( TYPESP* p )
+#endif
+        {
+            if constexpr ( IS_INTRUSIVE )
+            {
+                // The count lives in the object itself; adopting a pointer
+                // is just an increment, with no control block allocation.
+                m_internalObject = p;
+                if ( nullptr != p )
+                {
+                    p->AddRef();
+#ifdef WBS_PTR_PROFILE
+                    PtrProfile::RecordAlloc( p, site );
+#endif
+#ifdef WBS_TP_VALIDATE
+                    // The non-intrusive path stamps through the embedded
+                    // UP; the intrusive one has no UP, so stamp here.
+                    TPValidate::OnCreate( p );
+#endif
+                }
+            }
+            else
+            {
+#ifdef WBS_PTR_PROFILE
+                m_internalObject = new InternalObject( p, site );
+#else
+                m_internalObject = new InternalObject( p );
+#endif
+            }
+            m_objectPtr = p;
+        }
+
+        /**
+         * The aliasing constructor.  Shares ownership with an existing SP -
+         * typically of an enclosing object - while dereferencing to a
+         * member (or other sub-object) of it.  No new reference-count block
+         * is allocated; this SP joins the owner's, so the enclosing object
+         * stays alive for as long as any alias to it does.
+         *
+         * @param owner  - the SP whose ownership (and count block) is shared.
+         * @param member - the pointer this SP dereferences to, normally into
+         *                 the object the owner manages.  Its lifetime must be
+         *                 tied to the owner's object.
+         *
+         * @note A null owner yields a null SP; the member pointer is ignored.
+         */
+        template< typename TYPEOWNER >
+        SP( const SP< TYPEOWNER, POLICY >& owner, TYPESP* member )
+        {
+            static_assert( !IS_INTRUSIVE &&
+                           !SP< TYPEOWNER, POLICY >::IS_INTRUSIVE,
+                           "Aliasing requires a shared count block, which "
+                           "intrusive (RefCounted) classes do not have." );
+
+            m_internalObject = owner.m_internalObject;
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->AddRef();
+                m_objectPtr = member;
+            }
+            else
+            {
+                m_objectPtr = nullptr;
+            }
+        }
+
+        /**
+         * The Destructor.
+         * This MAY delete the referenced object, IF the embedded tracking
+         * count has gone to zero.
+         */
+        ~SP()
+        {
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->DecRef();
+            }
+        }
+
+        /**
+         * The copy constructor.
+         *
+         * @param other - The other SP to share ownership of the embedded object
+         *                with.
+         */
+        SP( const SP< TYPESP, POLICY >& other )
+        {
+            m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->AddRef();
+            }
+        }
+
+        /**
+         * The move semantics copy constructor.
+         *
+         * @param other - The other SP to pass ownership of the embedded object
+         *                with.
+         */
+        SP( SP< TYPESP, POLICY >&& other )
+        {
+            // Move the internal reference object and clear the passed
+            // reference.  We can ignore reference counts as it'll be a
+            // remove one followed by an add one.  Net zero.
+            m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
+            other.m_internalObject = nullptr;
+            other.m_objectPtr = nullptr;
+        }
+
+        /**
+         * The assignment operator.
+         *
+         * @param other - The other SP to share ownership of the embedded object
+         *                with.
+         *
+         * @return The reference to this pointer.
+         */
+        SP& operator=( const SP< TYPESP, POLICY >& other )
+        {
+            // Skip self-assignment.
+            if ( &other != this )
+            {
+                // Counts only change when the internal object does.  Two
+                // aliased SPs can share a count block yet dereference to
+                // different sub-objects, so the object pointer is copied
+                // unconditionally below.
+                if ( other.m_internalObject != m_internalObject )
+                {
+                    // If we were already pointing to an object, decrement
+                    // the reference to it.
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->DecRef();
+                    }
+
+                    // Assign the internal pointer and increment the
+                    // reference.
+                    m_internalObject = other.m_internalObject;
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->AddRef();
+                    }
+                }
+
+                m_objectPtr = other.m_objectPtr;
+            }
+
+            return *this;
+        }
+
+        /**
+         * The move semantics assignment operator.
+         *
+         * @param other - The other SP to share ownership of the embedded object
+         *                with.
+         *
+         * @return The reference to this pointer.
+         */
+        SP& operator=( SP< TYPESP, POLICY >&& other )
+        {
+            // Skip self-assignment and assignment to the same internal object.
+            if ( &other != this )
+            {
+                // If we were already pointing to an object, decrement the
+                // reference to it.
+                if ( nullptr != m_internalObject )
+                {
+                    m_internalObject->DecRef();
+                }
+
+                // Assign the internal pointer.  We can ignore reference counts
+                // as it'll be a remove one followed by an add one.  Net zero.
+                m_internalObject = other.m_internalObject;
+                m_objectPtr = other.m_objectPtr;
+
+                // Clear the input SP's internal pointer.
+                other.m_internalObject = nullptr;
+                other.m_objectPtr = nullptr;
+            }
+
+            return *this;
+        }
+
+        // Operations ----------------------------------------------------------
+        /**
+         * The arrow operator.
+         *
+         * @return The pointer to the referenced object.  If this pointer is
+         *         unset (null), returns nullptr.
+         */
+        TYPESP* operator->()
+        {
+            return m_objectPtr;
+        }
+
+        /**
+         * The star operator.
+         *
+         * @return A reference to the pointed-to object.
+         *
+         * @note If the internal pointer is null, this will be the same as
+         *       dereferencing a null pointer such as:
+         *       char* p = nullptr;
+         *       char c = *p;
+         */
+        TYPESP& operator*()
+        {
+            return *m_objectPtr;
+        }
+
+        /**
+         * Assignment from a c-style raw pointer.
+         *
+         * @param p - the c-style raw pointer to an object of type TYPESP.
+         *
+         * @return The reference to this pointer.
+         */
+        SP& operator=( TYPESP* p )
+        {
+            // Clear any existing reference.
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->DecRef();
+            }
+
+            if constexpr ( IS_INTRUSIVE )
+            {
+                m_internalObject = p;
+                if ( nullptr != p )
+                {
+                    p->AddRef();
+#ifdef WBS_TP_VALIDATE
+                    TPValidate::OnCreate( p );
+#endif
+                }
+            }
+            else
+            {
+                m_internalObject = new InternalObject( p );
+            }
+            m_objectPtr = p;
+
+            return *this;
+        }
+
+        /**
+         * Assignment from a UP.  MUST use move semantics to give up ownership.
+         *
+         * @param p - the c-style raw pointer to an object of type TYPESP.
+         *
+         * @return The reference to this pointer.
+         */
+        SP& operator=( UP< TYPESP >&& p )
+        {
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->DecRef();
+            }
+
+            if constexpr ( IS_INTRUSIVE )
+            {
+                m_internalObject = p.UnsafeAccess();
+                if ( nullptr != m_internalObject )
+                {
+                    m_internalObject->AddRef();
+                }
+            }
+            else
+            {
+                m_internalObject = new InternalObject( p.UnsafeAccess() );
+            }
+            m_objectPtr = p.UnsafeAccess();
+
+            p.m_ptr = nullptr;
+
+            return *this;
+        }
+
+        /**
+         * Comparison operators.  Lumping these all together for ease.
+         *
+         * @param rhs - the right-hand-side of the comparison (this is lhs)
+         *
+         * @return true if this pointer has the relationship to the rhs as
+         *         specified.
+         */
+        inline bool operator==( const SP< TYPESP, POLICY >& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
+        inline bool operator!=( const SP< TYPESP, POLICY >& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
+        inline bool operator<( const SP< TYPESP, POLICY >& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
+        inline bool operator<=( const SP< TYPESP, POLICY >& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
+        inline bool operator>( const SP< TYPESP, POLICY >& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
+        inline bool operator>=( const SP< TYPESP, POLICY >& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Unsafe access to the embedded c-style raw pointer.
+         *
+         * @return the internal TYPESP*, or nullptr if unassigned.
+         */
+        TYPESP* UnsafeAccess() const
+        {
+            return m_objectPtr;
+        }
+
+        /**
+         * Delete the object AS FAR AS THIS POINTER IS CONCERNED.  That is, this
+         * method decrements the internal counter, and if it goes to zero, the
+         * object is deleted.  Either way, the internal pointer is set to
+         * nullptr.
+         */
+        void Delete()
+        {
+            if ( nullptr != m_internalObject )
+            {
+                m_internalObject->DecRef();
+                m_internalObject = nullptr;
+                m_objectPtr = nullptr;
+            }
+        }
+
+        /**
+         * Determined if this pointer is pointing to anything.
+         *
+         * @return true if the internal reference is null, false otherwise.
+         */
+        bool IsNull()
+        {
+            return ( nullptr == m_internalObject );
+        }
+
+        /**
+         * The number of SPs currently sharing the object.  Works in both
+         * the external-control-block and intrusive (RefCounted) modes.
+         *
+         * @return The shared reference count (0 for a null SP).
+         *
+         * @note Under the BiasedThreaded policy the owner's references are
+         *       represented by a single stub, so treat the result as
+         *       alive/dead rather than an exact count (see
+         *       ControlBlock::StrongCount).
+         */
+        std::uint32_t UseCount() const
+        {
+            return ( nullptr != m_internalObject )
+                       ? m_internalObject->StrongCount()
+                       : 0;
+        }
+
+    private:
+        // We'll need to  make weak ptr (WP) a friend so it can access the
+        // same InternalObject as SPs of the type..
+        friend class wbs::WP< TYPESP, POLICY >;
+
+        // Every SP instantiation is a friend of every other, so the aliasing
+        // constructor can share the owner's count block across object types.
+        template< typename OTHERTYPE, typename OTHERPOLICY > friend class SP;
+
+        // The single-allocation factory needs access to the InternalObject
+        // to lay out the combined block.
+        template < typename T, typename P, typename... ARGS >
+        friend SP< T, P > MakeSP( ARGS&&... args );
+
+        // The bulk span operations manipulate both members and the counts
+        // directly, coalescing repeated blocks (see the bottom of this
+        // file).
+        template< typename T, typename P >
+        friend void CopySpan( SP< T, P >* dst, const SP< T, P >* src,
+                              std::size_t count );
+
+        template< typename T, typename P >
+        friend void ReleaseSpan( SP< T, P >* span, std::size_t count );
+
+        // Builds an SP whose object and InternalObject share one memory
+        // block.  Called by MakeSP (a friend); see the combined-allocation
+        // helpers in InternalObject for the block layout.
+        template < typename... ARGS >
+        static SP< TYPESP, POLICY > MakeCombined( ARGS&&... args )
+        {
+            if constexpr ( IS_INTRUSIVE )
+            {
+                // Intrusive classes are already single-allocation: the count
+                // lives in the object.  Just construct and adopt.
+                return SP< TYPESP, POLICY >(
+                    new TYPESP( std::forward< ARGS >( args )... ) );
+            }
+            else
+            {
+                void* mem = InternalObject::AllocateCombined();
+                TYPESP* obj = reinterpret_cast< TYPESP* >(
+                    static_cast< char* >( mem )
+                    + InternalObject::ObjectOffset() );
+
+                // Construct the object first, so a throwing constructor
+                // leaves nothing behind but the raw block, which we can
+                // simply free.
+                try
+                {
+                    ::new ( static_cast< void* >( obj ) )
+                        TYPESP( std::forward< ARGS >( args )... );
+                }
+                catch ( ... )
+                {
+                    InternalObject::FreeCombined( mem );
+                    throw;
+                }
+
+                // The InternalObject is constructed in place at the head of
+                // the block, flagged as combined so destruction tears the
+                // block down as a unit.
+                SP< TYPESP, POLICY > ret;
+                ret.m_internalObject =
+                    ::new ( mem ) InternalObject( obj, true );
+                ret.m_objectPtr = obj;
+
+                return ret;
+            }
+        }
+
+        // Attributes ----------------------------------------------------------
+        // Inner class to manage reference counts and the object pointer.  Note
+        // that this model holds a disadvantage to the std::shared_ptr as this
+        // class is allocated for every object.  std::shared_ptr manages the
+        // allocation and puts the extra space needed in the allocated object,
+        // requiring a single memory allocation for both object and the
+        // shared_ptr internal storage.  This trade-off allows for a cleaner
+        // implementation, as well as the ability to use SPs with any pre-
+        // existing object (see assignment from UPs).  For this implementation,
+        // that could be mitigated by using an object/memory pool for this
+        // class.
+        // @note Uses MemCache to minimize overhead of allocating
+        //       InternalObjects - cache-line-aligned under the contended
+        //       policies, so two unrelated SPs' count updates never
+        //       false-share a line.  SingleThreaded count blocks see no
+        //       cross-thread traffic and keep the dense packing.
+        class InternalObject
+        : public ControlBlock< POLICY >,
+          public MemCache< InternalObject,
+                           std::is_same_v< POLICY, SingleThreaded >
+                               ? 0
+                               : CACHE_LINE_SIZE >
+        {
+        public:
+            // Constructors, destructor, and Assignment operator ---------------
+            // Set up the pointer, and start with a count of 1 shared reference
+            // (the one creating this object).  The weak count starts at 1 as
+            // well, because the set of shared references collectively holds
+            // one weak reference (see ControlBlock::DecRef).  This "implicit
+            // weak reference" trick is what lets the two counters be
+            // manipulated independently without a lock tying them together.
+            InternalObject( TYPESP* p )
+            : ControlBlock< POLICY >( Base::STRONG_ONE + Base::WEAK_ONE ),
+              m_ptr( p )
+            {
+            }
+
+#ifdef WBS_PTR_PROFILE
+            // Profiling variant: forwards the adopting SP's call site into
+            // the embedded UP, so the table shows the user's line rather
+            // than this one.
+            InternalObject( TYPESP* p, PtrProfile::SiteArg site )
+            : ControlBlock< POLICY >( Base::STRONG_ONE + Base::WEAK_ONE ),
+              m_ptr( p, site )
+            {
+            }
+#endif
+
+            // Combined-allocation constructor, used by MakeSP.  The object
+            // lives in the same memory block as this InternalObject (at
+            // ObjectOffset() bytes in), so the COMBINED flag is set to route
+            // destruction accordingly: the object is destroyed in place, and
+            // the whole block is freed in one operation when the last
+            // reference (of either kind) goes away.
+            InternalObject( TYPESP* p, bool combined )
+            : ControlBlock< POLICY >(
+                  Base::STRONG_ONE + Base::WEAK_ONE +
+                  ( combined ? Base::COMBINED_FLAG : 0 ) ),
+              m_ptr( p )
+            {
+            }
+
+            // Combined-allocation helpers -------------------------------------
+            // These manage the single memory block holding both this
+            // InternalObject and the object itself, as laid out by MakeSP:
+            // the InternalObject at the start of the block and the object at
+            // ObjectOffset() bytes in (padded up to the object's alignment).
+
+            // The offset of the object within a combined block.
+            static constexpr std::size_t ObjectOffset()
+            {
+                return ( ( sizeof( InternalObject ) + alignof( TYPESP ) - 1 )
+                         / alignof( TYPESP ) ) * alignof( TYPESP );
+            }
+
+            // The total size of a combined block.
+            static constexpr std::size_t CombinedSize()
+            {
+                return ObjectOffset() + sizeof( TYPESP );
+            }
+
+            // Allocates a combined block, through the class's own operator
+            // new when it provides one (so MemCache-style class allocators
+            // still fire), and through global new otherwise.  Over-aligned
+            // types always go through the global aligned allocator, since a
+            // class allocator is only obliged to satisfy the default
+            // alignment for the sizes it normally sees.
+            static void* AllocateCombined()
+            {
+                if constexpr ( alignof( TYPESP ) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ )
+                {
+                    return ::operator new( CombinedSize(),
+                                           std::align_val_t( alignof( TYPESP ) ) );
+                }
+                else if constexpr ( HasClassNew< TYPESP >::value )
+                {
+                    return TYPESP::operator new( CombinedSize() );
+                }
+                else
+                {
+                    return ::operator new( CombinedSize() );
+                }
+            }
+
+            // Frees a combined block, mirroring AllocateCombined's choice of
+            // allocator.  Prefers the class's unsized operator delete, then
+            // its sized one, then the matching global deallocator.
+            static void FreeCombined( void* mem )
+            {
+                if constexpr ( alignof( TYPESP ) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ )
+                {
+                    ::operator delete( mem,
+                                       std::align_val_t( alignof( TYPESP ) ) );
+                }
+                else if constexpr ( HasClassDelete< TYPESP >::value )
+                {
+                    TYPESP::operator delete( mem );
+                }
+                else if constexpr ( HasClassSizedDelete< TYPESP >::value )
+                {
+                    TYPESP::operator delete( mem, CombinedSize() );
+                }
+                else
+                {
+                    ::operator delete( mem );
+                }
+            }
+
+        private:
+            // Shorthand for the (dependent) count base.
+            using Base = ControlBlock< POLICY >;
+
+            ~InternalObject() override
+            {
+                m_ptr.Delete();
+            }
+
+            // Destroys the managed object, called by the base when the last
+            // shared reference goes away.
+            void DisposeObject() override
+            {
+                if ( Base::IsCombined() )
+                {
+                    // The object shares our memory block: destroy it in
+                    // place, but leave the block itself alone.  The block
+                    // is freed as a whole when this InternalObject goes
+                    // away (see DestroySelf).  Under epoch mode the
+                    // destruction waits for the readers, like any other
+                    // delete.
+#ifdef WBS_PTR_PROFILE
+                    // The in-place destruction bypasses the embedded UP's
+                    // delete path, so record the release here.
+                    PtrProfile::RecordFree( m_ptr.UnsafeAccess() );
+#endif
+                    if ( EpochReclaim::Enabled() )
+                    {
+                        // The generation stamp retires with the deferred
+                        // destructor: pinned TP readers may dereference
+                        // until reclamation actually runs.
+                        EpochReclaim::Retire( m_ptr.UnsafeRelease(),
+                                              []( void* obj )
+                        {
+#ifdef WBS_TP_VALIDATE
+                            TPValidate::OnDestroy( obj );
+#endif
+                            static_cast< TYPESP* >( obj )->~TYPESP();
+                        } );
+                    }
+                    else
+                    {
+#ifdef WBS_TP_VALIDATE
+                        // The in-place destruction bypasses the embedded
+                        // UP's delete path, so retire the stamp here.
+                        TPValidate::OnDestroy( m_ptr.UnsafeAccess() );
+#endif
+                        m_ptr.UnsafeAccess()->~TYPESP();
+                        m_ptr.UnsafeRelease();
+                    }
+                }
+                else
+                {
+                    m_ptr.Delete();
+                }
+            }
+
+            // Frees this block, called by the base when the last weak
+            // reference goes away.
+            void DestroySelf() override
+            {
+                if ( Base::IsCombined() )
+                {
+                    // We share our memory block with the (already
+                    // destroyed) object, so free the whole block through
+                    // the same allocator MakeSP obtained it from.  Under
+                    // epoch mode the free is retired too: the object lives
+                    // inside this block, and retirement order guarantees
+                    // its (also retired) destructor runs first.
+                    if ( EpochReclaim::Enabled() )
+                    {
+                        EpochReclaim::Retire( this, []( void* mem )
+                        {
+                            InternalObject* self =
+                                static_cast< InternalObject* >( mem );
+                            self->~InternalObject();
+                            FreeCombined( self );
+                        } );
+                    }
+                    else
+                    {
+                        this->~InternalObject();
+                        FreeCombined( this );
+                    }
+                }
+                else
+                {
+                    // A separate block is never dereferenced by TP readers,
+                    // only the object is, so it can go inline.
+                    delete this;
+                }
+            }
+
+            // Attributes ------------------------------------------------------
+            // Use an embedded UP to manage the object itself.  When this object
+            // self-deletes, this UP deletes the object it points to.
+            UP< TYPESP > m_ptr;
+        };
+
+        // The internal object that all of the shared pointers for this object
+        // use to keep track of the object itself ands the count of existing
+        // SPs.  It handles deleting itself if the count of holding SPs goes to
+        // zero.  Held through the type-erased ControlBlock base so aliased
+        // SPs of other object types can share it.  In intrusive mode (see
+        // RefCounted) the object IS its own internal object, so this is
+        // simply the object pointer.
+        using Block = std::conditional_t< IS_INTRUSIVE,
+                                          TYPESP,
+                                          ControlBlock< POLICY > >;
+        Block* m_internalObject;
+
+        // The pointer operator-> and friends hand out.  Normally this is the
+        // object the count block manages, but an aliasing SP points it at a
+        // sub-object instead.  Null exactly when m_internalObject is null.
+        TYPESP* m_objectPtr;
+
+        // A constructor for use by a WP, that initializes an SP based on the
+        // count block and object pointer the WP captured.  This effectively
+        // promotes a weak pointer to a new shared pointer.
+        SP( ControlBlock< POLICY >* block, TYPESP* obj )
+        {
+            // The reference is claimed with a single increment-if-not-zero
+            // (see ControlBlock::TryAddRef), so a promotion racing the
+            // final DecRef either wins the reference outright or yields a
+            // null SP - it can never resurrect a dying object.
+            if ( ( nullptr != block ) && block->TryAddRef() )
+            {
+                m_internalObject = block;
+                m_objectPtr = obj;
+            }
+            else
+            {
+                m_internalObject = nullptr;
+                m_objectPtr = nullptr;
+            }
+        }
+    };
+
+    /**
+     * @class SP< TYPESP[] >
+     * The array form: SP< T[] > shares ownership of a buffer allocated
+     * with new[] and destroys it with delete[] when the last reference
+     * goes away.  Element access is operator[]; there is no operator->
+     * or operator*, matching UP's array convention, and the size is not
+     * tracked (pair with a Span; see Span.h).
+     *
+     * Deliberately leaner than the scalar form: arrays have no intrusive
+     * (RefCounted) mode, no aliasing constructor, no combined MakeSP
+     * allocation, and no weak pointers.  The count block is the same
+     * type-erased, MemCache-backed InternalObject arrangement, holding
+     * the buffer through a UP< TYPESP[] >.
      */
-    template< typename TYPESP > class SP
+    template< typename TYPESP, typename POLICY >
+    class SP< TYPESP[], POLICY >
     {
     public:
         // Constructors, destructor, and Assignment operator -------------------
         /**
-         * The Default Constructor.
+         * Default constructor; the null SP.
          */
         SP()
         {
             m_internalObject = nullptr;
+            m_objectPtr = nullptr;
         }
 
         /**
-         * A constructor from a c-style raw pointer.  This takes ownership from
-         * the passed raw pointer and handles destroying the passed object.
+         * A constructor from a c-style raw pointer (the result of
+         * new TYPESP[ n ]).  This takes ownership from the passed raw
+         * pointer; the buffer is destroyed with delete[] when the last
+         * SP lets go.
          *
-         * @param p - The c-style raw pointer whose object will be managed by
-         *            this SP.
+         * @param p - the buffer this SP (and its copies) will manage.
          */
         SP( TYPESP* p )
         {
             m_internalObject = new InternalObject( p );
+            m_objectPtr = p;
         }
 
         /**
-         * The Destructor.
-         * This MAY delete the referenced object, IF the embedded tracking
-         * count has gone to zero.
+         * Move constructor from an array UP, transferring ownership into
+         * shared management.
+         *
+         * @param other - the UP giving up its buffer.
          */
-        ~SP()
+        SP( UP< TYPESP[] >&& other )
         {
-            if ( nullptr != m_internalObject )
-            {
-                m_internalObject->DecRef();
-            }
+            m_objectPtr = other.UnsafeRelease();
+            m_internalObject = new InternalObject( m_objectPtr );
         }
 
         /**
-         * The copy constructor.
-         *
-         * @param other - The other SP to share ownership of the embedded object
-         *                with.
+         * Copy constructor; adds a shared reference to the buffer.
          */
-        SP( const SP< TYPESP >& other )
+        SP( const SP& other )
         {
             m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
             if ( nullptr != m_internalObject )
             {
                 m_internalObject->AddRef();
@@ -95,78 +1539,68 @@ namespace wbs
         }
 
         /**
-         * The move semantics copy constructor.
-         *
-         * @param other - The other SP to pass ownership of the embedded object
-         *                with.
+         * Move constructor; takes over the other SP's reference.
          */
-        SP( SP< TYPESP >&& other )
+        SP( SP&& other )
         {
-            // Move the internal reference object and clear the passed
-            // reference.  We can ignore reference counts as it'll be a
-            // remove one followed by an add one.  Net zero.
             m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
             other.m_internalObject = nullptr;
+            other.m_objectPtr = nullptr;
         }
 
         /**
-         * The assignment operator.
-         *
-         * @param other - The other SP to share ownership of the embedded object
-         *                with.
-         *
-         * @return The reference to this pointer.
+         * The Destructor.  Releases this SP's reference; the last one out
+         * deletes the buffer.
          */
-        SP& operator=( const SP< TYPESP >& other )
+        ~SP()
         {
-            // Skip self-assignment and assignment to the same internal object.
-            if ( ( &other != this ) &&
-                 ( other.m_internalObject != m_internalObject ) )
+            if ( nullptr != m_internalObject )
             {
-                // If we were already pointing to an object, decrement the
-                // reference to it.
-                if ( nullptr != m_internalObject )
-                {
-                    m_internalObject->DecRef();
-                }
+                m_internalObject->DecRef();
+            }
+        }
 
-                // Assign the internal pointer and increment the reference.
-                m_internalObject = other.m_internalObject;
-                if ( nullptr != m_internalObject )
+        /**
+         * Copy assignment operator.
+         */
+        SP& operator=( const SP& other )
+        {
+            if ( &other != this )
+            {
+                if ( other.m_internalObject != m_internalObject )
                 {
-                    m_internalObject->AddRef();
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->DecRef();
+                    }
+                    m_internalObject = other.m_internalObject;
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->AddRef();
+                    }
                 }
+                m_objectPtr = other.m_objectPtr;
             }
 
             return *this;
         }
 
         /**
-         * The move semantics assignment operator.
-         *
-         * @param other - The other SP to share ownership of the embedded object
-         *                with.
-         *
-         * @return The reference to this pointer.
+         * Move assignment operator.
          */
-        SP& operator=( SP< TYPESP >&& other )
+        SP& operator=( SP&& other )
         {
-            // Skip self-assignment and assignment to the same internal object.
             if ( &other != this )
             {
-                // If we were already pointing to an object, decrement the
-                // reference to it.
                 if ( nullptr != m_internalObject )
                 {
                     m_internalObject->DecRef();
                 }
-
-                // Assign the internal pointer.  We can ignore reference counts
-                // as it'll be a remove one followed by an add one.  Net zero.
                 m_internalObject = other.m_internalObject;
-
-                // Clear the input SP's internal pointer.
+                m_objectPtr = other.m_objectPtr;
                 other.m_internalObject = nullptr;
+                other.m_objectPtr = nullptr;
             }
 
             return *this;
@@ -174,311 +1608,275 @@ namespace wbs
 
         // Operations ----------------------------------------------------------
         /**
-         * The arrow operator.
-         *
-         * @return The pointer to the referenced object.  If this pointer is
-         *         unset (null), returns nullptr.
-         */
-        TYPESP* operator->()
-        {
-            if ( nullptr == m_internalObject )
-            {
-                return nullptr;
-            }
-            else
-            {
-                return m_internalObject->GetPtr();
-            }
-        }
-
-        /**
-         * The star operator.
+         * Element access.  No bounds checking; the SP does not know the
+         * buffer's length.
          *
-         * @return A reference to the pointed-to object.
+         * @param index - the element index.
          *
-         * @note If the internal pointer is null, this will be the same as
-         *       dereferencing a null pointer such as:
-         *       char* p = nullptr;
-         *       char c = *p;
+         * @return A reference to the element.
          */
-        TYPESP& operator*()
+        TYPESP& operator[]( std::size_t index ) const
         {
-            return *( m_internalObject->GetPtr() );
+            return m_objectPtr[ index ];
         }
 
         /**
-         * Assignment from a c-style raw pointer.
+         * Comparison operators.  Lumping these all together for ease.
          *
-         * @param p - the c-style raw pointer to an object of type TYPESP.
+         * @param rhs - the right-hand-side of the comparison (this is lhs)
          *
-         * @return The reference to this pointer.
+         * @return true if this pointer has the relationship to the rhs as
+         *         specified.
          */
-        SP& operator=( TYPESP* p )
-        {
-            // Clear any existing reference.
-            if ( nullptr != m_internalObject )
-            {
-                m_internalObject->DecRef();
-            }
-
-            m_internalObject = new InternalObject( p );
-
-            return *this;
-        }
+        inline bool operator==( const SP& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
+        inline bool operator!=( const SP& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
+        inline bool operator<( const SP& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
+        inline bool operator<=( const SP& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
+        inline bool operator>( const SP& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
+        inline bool operator>=( const SP& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
 
+        // Methods -------------------------------------------------------------
         /**
-         * Assignment from a UP.  MUST use move semantics to give up ownership.
-         *
-         * @param p - the c-style raw pointer to an object of type TYPESP.
-         *
-         * @return The reference to this pointer.
+         * Releases this SP's reference to the buffer (deleting the buffer
+         * if this was the last one) and nulls this SP.
          */
-        SP& operator=( UP< TYPESP >&& p )
+        void Delete()
         {
             if ( nullptr != m_internalObject )
             {
                 m_internalObject->DecRef();
+                m_internalObject = nullptr;
+                m_objectPtr = nullptr;
             }
-
-            m_internalObject = new InternalObject( p.UnsafeAccess() );
-
-            p.m_ptr = nullptr;
-
-            return *this;
         }
 
         /**
-         * Comparison operators.  Lumping these all together for ease.
-         *
-         * @param rhs - the right-hand-side of the comparison (this is lhs)
-         *
-         * @return true if this pointer has the relationship to the rhs as
-         *         specified.
-         */
-        inline bool operator==( const SP< TYPESP >& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
-        inline bool operator!=( const SP< TYPESP >& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
-        inline bool operator<( const SP< TYPESP >& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
-        inline bool operator<=( const SP< TYPESP >& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
-        inline bool operator>( const SP< TYPESP >& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
-        inline bool operator>=( const SP< TYPESP >& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
-
-        // Methods -------------------------------------------------------------
-        /**
-         * Unsafe access to the embedded c-style raw pointer.
+         * Checks if the internal pointer is null.
          *
-         * @return the internal TYPESP*, or nullptr if unassigned.
+         * @return true is the internal pointer is nullptr, otherwise false.
          */
-        TYPESP* UnsafeAccess() const
+        bool IsNull() const
         {
-            // Clear any existing reference.
-            if ( nullptr == m_internalObject )
-            {
-                return nullptr;
-            }
-            else
-            {
-                return m_internalObject->GetPtr();
-            }
+            return ( nullptr == m_internalObject );
         }
 
         /**
-         * Delete the object AS FAR AS THIS POINTER IS CONCERNED.  That is, this
-         * method decrements the internal counter, and if it goes to zero, the
-         * object is deleted.  Either way, the internal pointer is set to
-         * nullptr.
+         * The number of SPs currently sharing the buffer.
+         *
+         * @return The shared reference count (0 for a null SP).
          */
-        void Delete()
+        std::uint32_t UseCount() const
         {
-            if ( nullptr != m_internalObject )
-            {
-                m_internalObject->DecRef();
-                m_internalObject = nullptr;
-            }
+            return ( nullptr != m_internalObject )
+                       ? m_internalObject->StrongCount()
+                       : 0;
         }
 
         /**
-         * Determined if this pointer is pointing to anything.
+         * Pointer access.
          *
-         * @return true if the internal reference is null, false otherwise.
+         * @note This is considered an unsafe operation and should be avoided.
+         *       Possible exceptions include passing a TEMPORARY pointer to
+         *       a system or third party function/method.
+         *
+         * @return The raw pointer to the buffer.
          */
-        bool IsNull()
+        TYPESP* UnsafeAccess() const
         {
-            return ( nullptr == m_internalObject );
+            return m_objectPtr;
         }
 
     private:
-        // We'll need to  make weak ptr (WP) a friend so it can access the
-        // same InternalObject as SPs of the type..
-        friend class wbs::WP< TYPESP >;
-
-        // Attributes ----------------------------------------------------------
-        // Inner class to manage reference counts and the object pointer.  Note
-        // that this model holds a disadvantage to the std::shared_ptr as this
-        // class is allocated for every object.  std::shared_ptr manages the
-        // allocation and puts the extra space needed in the allocated object,
-        // requiring a single memory allocation for both object and the
-        // shared_ptr internal storage.  This trade-off allows for a cleaner
-        // implementation, as well as the ability to use SPs with any pre-
-        // existing object (see assignment from UPs).  For this implementation,
-        // that could be mitigated by using an object/memory pool for this
-        // class.
-        // @note Uses MemCache to minimize overhead of allocating
-        //       InternalObjects.
+        // The count block: the same arrangement as the scalar form's, with
+        // the buffer held through an array UP so the final release runs
+        // delete[], and the same cache-line isolation under the contended
+        // policies.
         class InternalObject
-        : public MemCache< InternalObject >
+        : public ControlBlock< POLICY >,
+          public MemCache< InternalObject,
+                           std::is_same_v< POLICY, SingleThreaded >
+                               ? 0
+                               : CACHE_LINE_SIZE >
         {
         public:
-            // Constructors, destructor, and Assignment operator ---------------
-            // Set up the pointer, and start with a count of 1 shared reference
-            //  (the one creating this object), and no weak references.
             InternalObject( TYPESP* p )
-            : m_ptr( p ), m_refCount( 1 ), m_weakRefCount( 0 )
+            : ControlBlock< POLICY >( Base::STRONG_ONE + Base::WEAK_ONE ),
+              m_ptr( p )
             {
             }
 
-            // Increments the reference count.
-            void AddRef()
+        private:
+            using Base = ControlBlock< POLICY >;
+
+            ~InternalObject() override
             {
-                // Lock access to keep reference counts from being modified
-                // at the same time.
-                m_lock.lock();
-                ++m_refCount;
-                m_lock.unlock();
+                m_ptr.Delete();
             }
 
-            // Decrement the reference count, and if the refCount is then zero,
-            // delete the object we point to.  We also destroy this inner object
-            // if we have no shared nor weak pointers pointing to it.
-            void DecRef()
+            void DisposeObject() override
             {
-                bool deleteMe = false;
-
-                // Lock access until we get the counters figured out.
-                m_lock.lock();
-                --m_refCount;
-                if ( 0 == m_refCount )
-                {
-                    // Delete the referenced object.
-                    m_ptr.Delete();
-
-                    // If we have no weak pointers, delete this internal object.
-                    if ( 0 == m_weakRefCount )
-                    {
-                        // Have to release the lock first.  It's ok, if both
-                        // counters are zero, nothing is pointing to this, so
-                        // releasing the lock doesn't expose the object to
-                        // issues.
-                        deleteMe = true;
-                    }
-                }
-
-                // Unlock before we (maybe) delete.
-                m_lock.unlock();
-
-                // Zero references of either kind means we delete ourselves.
-                if ( deleteMe )
-                {
-                    delete this;
-                }
+                m_ptr.Delete();
             }
 
-            // Increments the weak reference count.
-            void AddWeakRef()
+            void DestroySelf() override
             {
-                // Lock access to keep reference counts from being modified
-                // at the same time.
-                m_lock.lock();
-                ++m_weakRefCount;
-                m_lock.unlock();
+                delete this;
             }
 
-            // Decrement the weak reference count, and self-delete if the weak
-            // and shared references are now zero.
-            void DecWeakRef()
-            {
-                bool deleteMe = false;
+            // The buffer, deleted with delete[] through the array UP.
+            UP< TYPESP[] > m_ptr;
+        };
 
-                // Lock access until we get the counters figured out.
-                m_lock.lock();
-                --m_weakRefCount;
-                if ( ( 0 == m_weakRefCount ) && ( 0 == m_refCount ) )
-                {
-                    // Note that the pointer should already be null with no
-                    // shared pointers.
-                    deleteMe = true;
-                }
+        // Attributes ----------------------------------------------------------
+        // The shared count block and the buffer it manages.  Unlike the
+        // scalar form there is no aliasing, so m_objectPtr always matches
+        // the block's buffer; it is kept for the same reason - element
+        // access without an indirection through the block.
+        ControlBlock< POLICY >* m_internalObject;
 
-                m_lock.unlock();
+        TYPESP* m_objectPtr;
+    };
 
-                // Zero references means we delete ourselves.
-                if ( deleteMe )
-                {
-                    delete this;
-                }
-            }
+    /**
+     * Creates an SP whose object and internal reference-count block share a
+     * SINGLE memory allocation, forwarding the passed arguments to the
+     * object's constructor.  Unlike std::make_shared, the allocation is
+     * obtained through the class's own operator new when it provides one
+     * (falling back to global new otherwise), so class-level allocators such
+     * as MemCache still fire.  This halves the allocation/free traffic of
+     * creating a shared object versus SP< T >( new T( ... ) ).
+     *
+     * @param args - the arguments to forward to TYPESP's constructor.
+     *
+     * @return An SP owning the newly constructed object.
+     */
+    template < typename TYPESP, typename POLICY, typename... ARGS >
+    SP< TYPESP, POLICY > MakeSP( ARGS&&... args )
+    {
+        return SP< TYPESP, POLICY >::MakeCombined( std::forward< ARGS >( args )... );
+    }
+
+    /**
+     * Releases every SP in the passed span, leaving them all null.  The
+     * walk coalesces runs of SPs sharing a count block (snapshots are
+     * full of them - copies and aliases of the same objects sit together)
+     * into ONE count update per run, and makes no per-element calls, so
+     * dropping a 10k-element snapshot costs a single tight loop instead
+     * of 10k individual decrements.
+     *
+     * @param span  - the SPs to release.  May contain nulls.
+     * @param count - the number of elements in the span.
+     */
+    template< typename TYPESP, typename POLICY >
+    void ReleaseSpan( SP< TYPESP, POLICY >* span, std::size_t count )
+    {
+        std::size_t at = 0;
+        while ( at < count )
+        {
+            typename SP< TYPESP, POLICY >::Block* block =
+                span[ at ].m_internalObject;
 
-            TYPESP* GetPtr()
+            // Extend over the run of neighbors sharing this block.
+            std::size_t run = 1;
+            while ( ( ( at + run ) < count ) &&
+                    ( block == span[ at + run ].m_internalObject ) )
             {
-                return m_ptr.UnsafeAccess();
+                ++run;
             }
 
-        private:
-            ~InternalObject()
+            for ( std::size_t clear = at; clear < ( at + run ); ++clear )
             {
-                m_ptr.Delete();
+                span[ clear ].m_internalObject = nullptr;
+                span[ clear ].m_objectPtr = nullptr;
             }
 
-            // Attributes ------------------------------------------------------
-            // Use an embedded UP to manage the object itself.  When this object
-            // self-deletes, this UP deletes the object it points to.
-            UP< TYPESP > m_ptr;
-
-            // Keeps track of the number of shared pointers referencing this
-            // pointer.  When this goes to zero the referenced object is
-            // deleted.  When both this and the weakRefCount go to zero, this
-            // internal object deletes itself.
-            std::uint64_t m_refCount;
-
-            // Keeps track of the number of weak pointers referencing this
-            // pointer.  When both this and the shareds refCount go to zero,
-            // this internal object deletes itself.
-            std::uint64_t m_weakRefCount;
-
-            // Mutex to protect access to this object's counters.
-            // In particular, since we have 2 counters, we want to make sure
-            // one thread doesn't chage a weak pointer count while another
-            // changes a shared pointer count, and this object is left in limbo.
-            std::mutex m_lock;
+            if ( nullptr != block )
+            {
+                // One decrement covers the whole run; the zero-transition
+                // teardown happens at most once, as it must.
+                block->DecRef( static_cast< std::uint32_t >( run ) );
+            }
 
-        };
+            at += run;
+        }
+    }
 
-        // The internal object that all of the shared pointers for this object
-        // use to keep track of the object itself ands the count of existing
-        // SPs.  It handles deleting itself if the count of holding SPs goes to
-        // zero.
-        InternalObject* m_internalObject;
+    /**
+     * Copies a span of SPs into another span in one pass, releasing
+     * whatever the destination previously held.  Like ReleaseSpan, runs
+     * of source SPs sharing a count block are coalesced into one count
+     * update, so fanning a snapshot out to a worker is a release sweep, a
+     * memcpy-shaped copy loop, and one increment per distinct run.
+     *
+     * @param dst   - the destination span; its current references are
+     *                released first.  Must not overlap src.
+     * @param src   - the source span.  May contain nulls.
+     * @param count - the number of elements in both spans.
+     */
+    template< typename TYPESP, typename POLICY >
+    void CopySpan( SP< TYPESP, POLICY >* dst,
+                   const SP< TYPESP, POLICY >* src,
+                   std::size_t count )
+    {
+        ReleaseSpan( dst, count );
 
-        // A constructor for use by a WP, that initializes an SP based on the
-        // InternalObject pointer.  This effectively promotes a weak pointer to
-        // a new shared pointer.
-        SP( InternalObject* p )
+        std::size_t at = 0;
+        while ( at < count )
         {
-            // Note that the InternalObject must be non-null, and the internal
-            // pointer is also non-null to construct a useful SP.
-            if ( ( nullptr != p ) &&
-                 ( nullptr != p->GetPtr() ) )
-            {
+            typename SP< TYPESP, POLICY >::Block* block =
+                src[ at ].m_internalObject;
 
-                m_internalObject = p;
+            std::size_t run = 1;
+            while ( ( ( at + run ) < count ) &&
+                    ( block == src[ at + run ].m_internalObject ) )
+            {
+                ++run;
+            }
 
-                m_internalObject->AddRef();
+            for ( std::size_t copy = at; copy < ( at + run ); ++copy )
+            {
+                dst[ copy ].m_internalObject = src[ copy ].m_internalObject;
+                dst[ copy ].m_objectPtr = src[ copy ].m_objectPtr;
             }
-            else
+
+            if ( nullptr != block )
             {
-                m_internalObject = nullptr;
+                block->AddRef( static_cast< std::uint32_t >( run ) );
             }
+
+            at += run;
         }
-    };
+    }
+
+    /**
+     * Convenience overload: copies one vector of SPs into another,
+     * releasing the destination's current contents and resizing it to
+     * match the source.
+     *
+     * @param dst - the destination vector.
+     * @param src - the source vector.  Must not be the same vector.
+     */
+    template< typename TYPESP, typename POLICY >
+    void CopySpan( std::vector< SP< TYPESP, POLICY > >& dst,
+                   const std::vector< SP< TYPESP, POLICY > >& src )
+    {
+        ReleaseSpan( dst.data(), dst.size() );
+        dst.resize( src.size() );
+        CopySpan( dst.data(), src.data(), src.size() );
+    }
+
+    /**
+     * Convenience overload: releases every SP a vector holds, leaving the
+     * vector full of nulls (its size is unchanged; clear it separately if
+     * the slots are no longer wanted).
+     *
+     * @param span - the vector whose SPs are released.
+     */
+    template< typename TYPESP, typename POLICY >
+    void ReleaseSpan( std::vector< SP< TYPESP, POLICY > >& span )
+    {
+        ReleaseSpan( span.data(), span.size() );
+    }
 }; // End of namespace wbs
 
 #endif // #ifndef _OP_H_
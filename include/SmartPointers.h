@@ -4,16 +4,22 @@
  * Abstract:
  * General include for all smart pointer types.
  *
- * @see UP.h SP.h WP.h, TP.h
+ * @see UP.h SP.h WP.h, TP.h CowP.h Span.h Epoch.h PtrQueue.h PtrProfile.h TPValidate.h ObjectPool.h
  *
  * @copyright Working Bits Systems, LLC, 2023
  */
 #ifndef _SMARTPOINTERS_H_
 #define _SMARTPOINTERS_H_
 
+#include "Arena.h"
+#include "Epoch.h"
+#include "ObjectPool.h"
 #include "UP.h"
 #include "SP.h"
 #include "WP.h"
 #include "TP.h"
+#include "CowP.h"
+#include "Span.h"
+#include "PtrQueue.h"
 
 #endif // #ifndef _SMARTPOINTERS_H_
@@ -0,0 +1,294 @@
+/**
+ * Span.h
+ *
+ * Abstract:
+ * Definition of a template class that is a non-owning VIEW over a
+ * contiguous range of objects - the range counterpart of TP.  Hot
+ * numeric paths pass batches of values around, and without this class
+ * they fall back to raw (pointer, length) pairs, abandoning exactly the
+ * ownership-clarity rules the rest of the library enforces.  A Span
+ * makes the non-owning intent explicit while compiling down to the same
+ * two words, and exposes raw-pointer iterators so loops over it
+ * auto-vectorize just like loops over the underlying array.
+ *
+ * Like TP, a Span does not keep the viewed storage alive: the owner (a
+ * vector, an array, an Arena) must outlive every Span over it.
+ *
+ * @see TP.h UP.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "TP.h"
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    /**
+     * @class Span
+     *
+     * A view over count contiguous objects of type TYPESPAN.  Use
+     * Span< const T > for read-only views; a Span< const T > constructs
+     * freely from mutable storage, the same way const T* accepts T*.
+     *
+     * Like raw pointers and TPs, Spans don't track the source of the
+     * storage they view.  It is up to the developer to ensure the owning
+     * container or allocation outlives the Span.
+     */
+    template< class TYPESPAN > class Span
+    {
+        // The element type with const stripped, for constructing views of
+        // either constness over the same containers.
+        using MUTABLE_TYPE = typename std::remove_const< TYPESPAN >::type;
+
+    public:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Default constructor: an empty view.
+         */
+        Span< TYPESPAN >()
+        {
+            m_data = nullptr;
+            m_count = 0;
+        }
+
+        /**
+         * Constructor from a raw pointer and element count, for storage
+         * whose shape only the caller knows (Arena allocations, slices of
+         * larger buffers).
+         *
+         * @param data  - the first element of the range.
+         * @param count - the number of elements.
+         */
+        Span< TYPESPAN >( TYPESPAN* data, std::size_t count )
+        {
+            m_data = data;
+            m_count = count;
+        }
+
+        /**
+         * Constructor from a C array; the extent is deduced.
+         *
+         * @param data - the array to view.
+         */
+        template< std::size_t EXTENT >
+        Span< TYPESPAN >( TYPESPAN ( &data )[ EXTENT ] )
+        {
+            m_data = data;
+            m_count = EXTENT;
+        }
+
+        /**
+         * Constructor from a vector of the element type.
+         *
+         * @param owner - the vector whose elements are viewed.  The view
+         *                is invalidated by anything that reallocates the
+         *                vector, just as its iterators would be.
+         */
+        Span< TYPESPAN >( std::vector< MUTABLE_TYPE >& owner )
+        {
+            m_data = owner.data();
+            m_count = owner.size();
+        }
+
+        /**
+         * Constructor from a const vector, available for read-only views
+         * (Span< const T >) only.
+         *
+         * @param owner - the vector whose elements are viewed.
+         */
+        template< typename ELEMENT = TYPESPAN,
+                  typename = typename std::enable_if<
+                      std::is_const< ELEMENT >::value >::type >
+        Span< TYPESPAN >( const std::vector< MUTABLE_TYPE >& owner )
+        {
+            m_data = owner.data();
+            m_count = owner.size();
+        }
+
+        /**
+         * Copy constructor.  Spans don't own, so copies are free and
+         * unrestricted, like TP's.
+         */
+        Span< TYPESPAN >( const Span< TYPESPAN >& other )
+        {
+            m_data = other.m_data;
+            m_count = other.m_count;
+        }
+
+        /**
+         * A mutable view converts to a read-only view implicitly, the way
+         * T* converts to const T*.
+         */
+        template< typename ELEMENT = TYPESPAN,
+                  typename = typename std::enable_if<
+                      std::is_const< ELEMENT >::value >::type >
+        Span< TYPESPAN >( const Span< MUTABLE_TYPE >& other )
+        {
+            m_data = other.Data();
+            m_count = other.Size();
+        }
+
+        /**
+         * Assignment operator.
+         */
+        Span< TYPESPAN >& operator=( const Span< TYPESPAN >& other )
+        {
+            m_data = other.m_data;
+            m_count = other.m_count;
+
+            return *this;
+        }
+
+        // Operations ----------------------------------------------------------
+        /**
+         * Element access.  No bounds checking, like the raw loop this
+         * class replaces.
+         *
+         * @param index - the element index.
+         *
+         * @return A reference to the element.
+         */
+        TYPESPAN& operator[]( std::size_t index ) const
+        {
+            return m_data[ index ];
+        }
+
+        /*
+         * Comparison operators, following TP's identity semantics: two
+         * Spans are equal when they view the SAME range (same start, same
+         * length), and order by their start address.  Comparing contents
+         * is the caller's business (std::equal over the spans).
+         *
+         * @param other - the right-hand-side of the comparison.
+         *
+         * @return true if this span has the relationship to the rhs as
+         *         specified.
+         */
+        inline bool operator==( const Span< TYPESPAN >& other ) const { return ( m_data == other.m_data ) && ( m_count == other.m_count ); }
+        inline bool operator!=( const Span< TYPESPAN >& other ) const { return !( *this == other ); }
+        inline bool operator<( const Span< TYPESPAN >& other ) const  { return m_data < other.m_data; }
+        inline bool operator<=( const Span< TYPESPAN >& other ) const { return m_data <= other.m_data; }
+        inline bool operator>( const Span< TYPESPAN >& other ) const  { return m_data > other.m_data; }
+        inline bool operator>=( const Span< TYPESPAN >& other ) const { return m_data >= other.m_data; }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * The start of the viewed range, as a c-style raw pointer.
+         *
+         * @return The raw pointer (null for an empty default view).
+         */
+        TYPESPAN* Data() const
+        {
+            return m_data;
+        }
+
+        /**
+         * The number of elements viewed.
+         */
+        std::size_t Size() const
+        {
+            return m_count;
+        }
+
+        /**
+         * Checks whether the view is empty.
+         *
+         * @return true if the view has no elements.
+         */
+        bool IsEmpty() const
+        {
+            return ( 0 == m_count );
+        }
+
+        /**
+         * Clears the view (the storage itself is untouched; we don't own
+         * it).
+         */
+        void Release()
+        {
+            m_data = nullptr;
+            m_count = 0;
+        }
+
+        /**
+         * A sub-view of this view.
+         *
+         * @param offset - the first element of the sub-view.
+         * @param count  - the number of elements; clamped to what remains
+         *                 past the offset.
+         *
+         * @return The sub-view (empty if offset is past the end).
+         */
+        Span< TYPESPAN > SubSpan( std::size_t offset,
+                                  std::size_t count ) const
+        {
+            if ( offset >= m_count )
+            {
+                return Span< TYPESPAN >();
+            }
+            if ( count > ( m_count - offset ) )
+            {
+                count = m_count - offset;
+            }
+
+            return Span< TYPESPAN >( m_data + offset, count );
+        }
+
+        /*
+         * Iterators.  Raw pointers, deliberately: the compiler sees a
+         * plain pointer loop and vectorizes it exactly as it would the
+         * underlying array.  (Lowercase, as range-based for requires.)
+         */
+        TYPESPAN* begin() const
+        {
+            return m_data;
+        }
+
+        TYPESPAN* end() const
+        {
+            return m_data + m_count;
+        }
+
+    private:
+        // Attributes ----------------------------------------------------------
+        // The viewed range: first element and element count.
+        TYPESPAN*   m_data;
+        std::size_t m_count;
+    };
+
+    /**
+     * 2-operand comparison operators between Spans and TPs, following the
+     * cross-type family TP defines with UP and SP: a TP compares equal to
+     * a Span that starts at the object it points to.  Lumping these all
+     * together for ease.
+     *
+     * @param rhs - the right-hand-side of the comparison (this is lhs)
+     *
+     * @return true if this pointer has the relationship to the rhs as
+     *         specified.
+     */
+    template < typename TYPE > bool operator==( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() == rhs.RawAccess(); }
+    template < typename TYPE > bool operator!=( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() != rhs.RawAccess(); }
+    template < typename TYPE > bool operator<( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() < rhs.RawAccess(); }
+    template < typename TYPE > bool operator<=( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() <= rhs.RawAccess(); }
+    template < typename TYPE > bool operator>( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() > rhs.RawAccess(); }
+    template < typename TYPE > bool operator>=( const Span< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.Data() >= rhs.RawAccess(); }
+
+    template < typename TYPE > bool operator==( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() == rhs.Data(); }
+    template < typename TYPE > bool operator!=( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() != rhs.Data(); }
+    template < typename TYPE > bool operator<( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() < rhs.Data(); }
+    template < typename TYPE > bool operator<=( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() <= rhs.Data(); }
+    template < typename TYPE > bool operator>( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() > rhs.Data(); }
+    template < typename TYPE > bool operator>=( const TP< TYPE >& lhs, const Span< TYPE >& rhs ) { return lhs.RawAccess() >= rhs.Data(); }
+}; // End of namespace wbs
+
+#endif // #ifndef _SPAN_H_
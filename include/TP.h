@@ -13,7 +13,12 @@
  * determine the intended use of the raw pointer without tracking down its
  * source.  Using TP makes the intent clear in the code.
  *
- * @see UP.h SP.h
+ * In a WBS_TP_VALIDATE build (CI, canaries) every TP additionally captures
+ * the owner's generation stamp and asserts on each dereference that the
+ * object is still alive (see TPValidate.h).  Release builds compile none
+ * of that, so TP keeps its raw-pointer cost where it matters.
+ *
+ * @see UP.h SP.h TPValidate.h
  *
  * @copyright Copyright(C) Working Bits Systems, LLC 2023
  */
@@ -22,6 +27,7 @@
 
 #include "UP.h"
 #include "SP.h"
+#include "TPValidate.h"
 
 /*
  * The Working Bits Systems namespace.
@@ -54,28 +60,32 @@ namespace wbs
 
         /**
          * Constructor that makes a (non-owning) TP from an UP for the same
-         * object type.
+         * object type (under any deleter).
          *
          * @param owner - the UP that "owns" the allocated object.
          */
-        TP< TYPETP >( const UP< TYPETP >& owner )
+        template< typename DELETER >
+        TP< TYPETP >( const UP< TYPETP, DELETER >& owner )
         {
             // Yes, UnsafeAccess(), BUT being used to init the TP.  This is an
             // OK use of this method.
             m_ptr = owner.UnsafeAccess();
+            Capture();
         }
 
         /**
          * Constructor that makes a (non-owning) TP from an SP for the same
-         * object type.
+         * object type (under any threading policy).
          *
          * @param owner - the SP that shares ownership with the allocated object.
          */
-        TP< TYPETP >( const SP< TYPETP >& owner )
+        template< typename POLICY >
+        TP< TYPETP >( const SP< TYPETP, POLICY >& owner )
         {
             // Yes, UnsafeAccess(), BUT being used to init the TP.  This is an
             // OK use of this method.
             m_ptr = owner.UnsafeAccess();
+            Capture();
         }
 
         /**
@@ -93,6 +103,7 @@ namespace wbs
         TP< TYPETP >( const std::unique_ptr< TYPETP >& owner )
         {
             m_ptr = owner.get();
+            Capture();
         }
 
         /**
@@ -104,6 +115,7 @@ namespace wbs
         TP< TYPETP >( const std::shared_ptr< TYPETP >& owner )
         {
             m_ptr = owner.get();
+            Capture();
         }
 
         /**
@@ -118,6 +130,13 @@ namespace wbs
         TP< TYPETP >( const TP< TYPETP >& other )
         {
             m_ptr = other.m_ptr;
+#ifdef WBS_TP_VALIDATE
+            // The copy inherits the original's stamp rather than looking
+            // it up afresh: if the other TP is already dangling, a fresh
+            // capture could pick up whatever NOW lives at the address and
+            // mask the bug.
+            m_generation = other.m_generation;
+#endif
         }
 
         /**
@@ -132,6 +151,7 @@ namespace wbs
         TP< TYPETP >( const TYPETP* cptr )
         {
             m_ptr = const_cast< TYPETP* >( cptr );
+            Capture();
         }
 
         /**
@@ -151,6 +171,10 @@ namespace wbs
         TP< TYPETP >& operator=( const TP< TYPETP >& other )
         {
             m_ptr = other.m_ptr;
+#ifdef WBS_TP_VALIDATE
+            // As in the copy constructor: inherit, don't re-capture.
+            m_generation = other.m_generation;
+#endif
 
             return *this;
         }
@@ -160,9 +184,16 @@ namespace wbs
          * Pointer dereference operator.
          *
          * @return The pointer for dereferencing.
+         *
+         * @note In a WBS_TP_VALIDATE build this asserts the object still
+         *       carries the generation captured when this TP was pointed
+         *       at it; a failure means the TP outlived the object.
          */
         TYPETP* const operator->()
         {
+#ifdef WBS_TP_VALIDATE
+            assert( TPValidate::Valid( m_ptr, m_generation ) );
+#endif
             return m_ptr;
         }
 
@@ -170,9 +201,14 @@ namespace wbs
          * Object reference operator.
          *
          * @return A reference to the object pointed to by this TP.
+         *
+         * @note Validated in a WBS_TP_VALIDATE build, as operator-> is.
          */
         TYPETP& operator*()
         {
+#ifdef WBS_TP_VALIDATE
+            assert( TPValidate::Valid( m_ptr, m_generation ) );
+#endif
             return *m_ptr;
         }
 
@@ -208,6 +244,7 @@ namespace wbs
         void Release()
         {
             m_ptr = nullptr;
+            Capture();
         }
 
         /**
@@ -221,9 +258,26 @@ namespace wbs
         }
 
     private:
+        // Captures the current generation stamp of the pointed-at object
+        // for the validation build; objects no owner ever stamped capture
+        // zero and dereference unchecked.  Compiled away entirely in
+        // release builds.
+        void Capture()
+        {
+#ifdef WBS_TP_VALIDATE
+            m_generation = TPValidate::Capture( m_ptr );
+#endif
+        }
+
         // Attributes ----------------------------------------------------------
         // Points to the object we manage or null.
         TYPETP* m_ptr;
+
+#ifdef WBS_TP_VALIDATE
+        // The generation the object carried when this TP was pointed at
+        // it (see TPValidate.h); zero means unchecked.
+        std::uint64_t m_generation = 0;
+#endif
     };
 
     /**
@@ -249,19 +303,19 @@ namespace wbs
     template < typename TYPE > bool operator>( const UP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() > rhs.RawAccess(); }
     template < typename TYPE > bool operator>=( const UP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() >= rhs.RawAccess(); }
 
-    template < typename TYPE > bool operator==( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() == rhs.UnsafeAccess(); }
-    template < typename TYPE > bool operator!=( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() != rhs.UnsafeAccess(); }
-    template < typename TYPE > bool operator<( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() < rhs.UnsafeAccess(); }
-    template < typename TYPE > bool operator<=( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() <= rhs.UnsafeAccess(); }
-    template < typename TYPE > bool operator>( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() > rhs.UnsafeAccess(); }
-    template < typename TYPE > bool operator>=( const TP< TYPE >& lhs, const SP< TYPE >& rhs ) { return lhs.RawAccess() >= rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator==( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() == rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator!=( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() != rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator<( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() < rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator<=( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() <= rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator>( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() > rhs.UnsafeAccess(); }
+    template < typename TYPE, typename POL > bool operator>=( const TP< TYPE >& lhs, const SP< TYPE, POL >& rhs ) { return lhs.RawAccess() >= rhs.UnsafeAccess(); }
 
-    template < typename TYPE > bool operator==( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() == rhs.RawAccess(); }
-    template < typename TYPE > bool operator!=( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() != rhs.RawAccess(); }
-    template < typename TYPE > bool operator<( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() < rhs.RawAccess(); }
-    template < typename TYPE > bool operator<=( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() <= rhs.RawAccess(); }
-    template < typename TYPE > bool operator>( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() > rhs.RawAccess(); }
-    template < typename TYPE > bool operator>=( const SP< TYPE >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() >= rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator==( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() == rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator!=( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() != rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator<( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() < rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator<=( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() <= rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator>( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() > rhs.RawAccess(); }
+    template < typename TYPE, typename POL > bool operator>=( const SP< TYPE, POL >& lhs, const TP< TYPE >& rhs ) { return lhs.UnsafeAccess() >= rhs.RawAccess(); }
 
 }; // End of wbs namespace
 
@@ -0,0 +1,141 @@
+/**
+ * TPValidate.h
+ *
+ * Abstract:
+ * Opt-in lifetime validation for TPs, compiled only when WBS_TP_VALIDATE
+ * is defined (CI and canary builds); in its absence nothing in this file
+ * exists and TP keeps its raw-pointer cost.
+ *
+ * The scheme is a generation counter per owned object: the owners (UP and
+ * SP) stamp a fresh generation when they take charge of an object and
+ * retire the stamp when the object is destroyed.  A TP captures the stamp
+ * when it is pointed at the object, and every dereference re-checks it.
+ * A dangling TP - the object destroyed, or worse, destroyed and its
+ * memory recycled into a NEW object (which gets a new generation) - then
+ * fails an assert at the dereference, instead of silently reading freed
+ * memory.  Objects that were never owner-stamped (stack objects, members
+ * reached through an aliasing SP) capture generation zero and dereference
+ * unchecked, so adopting TPs incrementally raises no false alarms.
+ *
+ * @see TP.h UP.h SP.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#ifndef _TPVALIDATE_H_
+#define _TPVALIDATE_H_
+
+#ifdef WBS_TP_VALIDATE
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+/*
+ * The Working Bits Systems namespace.
+ */
+namespace wbs
+{
+    /**
+     * @class TPValidate
+     * The process-wide generation registry behind the validation build
+     * (see the file header).  The registry is a mutex-guarded map from
+     * object address to its current generation - this is a debugging
+     * facility, so the lock on every owner hand-off and TP dereference is
+     * an accepted cost; release builds compile none of it.
+     */
+    class TPValidate
+    {
+    public:
+        // Stamps a fresh generation on an object an owner just took
+        // charge of.  Re-adoption of a still-live object (a second SP
+        // wrapping the same RefCounted object, an embedded UP re-wrapping
+        // a released pointer) keeps the existing stamp, so TPs already
+        // watching the object stay valid.
+        static void OnCreate( const void* obj )
+        {
+            if ( nullptr == obj )
+            {
+                return;
+            }
+
+            std::lock_guard< std::mutex > hold( MapMutex() );
+            Generations().emplace( obj, NextGeneration() );
+        }
+
+        // Retires an object's stamp at destruction.  Any TP still holding
+        // the old generation fails its next dereference - even if a new
+        // object later lands on the same address, since that one gets a
+        // fresh generation.
+        static void OnDestroy( const void* obj )
+        {
+            if ( nullptr == obj )
+            {
+                return;
+            }
+
+            std::lock_guard< std::mutex > hold( MapMutex() );
+            Generations().erase( obj );
+        }
+
+        // The stamp a TP captures when pointed at an object: the current
+        // generation, or zero (dereference unchecked) if no owner ever
+        // stamped this address.
+        static std::uint64_t Capture( const void* obj )
+        {
+            if ( nullptr == obj )
+            {
+                return 0;
+            }
+
+            std::lock_guard< std::mutex > hold( MapMutex() );
+            auto entry = Generations().find( obj );
+
+            return ( Generations().end() != entry ) ? entry->second : 0;
+        }
+
+        // The dereference check: does the object still carry the captured
+        // generation?  Zero means the capture was unchecked.
+        static bool Valid( const void* obj, std::uint64_t generation )
+        {
+            if ( 0 == generation )
+            {
+                return true;
+            }
+
+            std::lock_guard< std::mutex > hold( MapMutex() );
+            auto entry = Generations().find( obj );
+
+            return ( Generations().end() != entry )
+                   && ( generation == entry->second );
+        }
+
+    private:
+        // Generations start at 1; 0 is reserved for "never stamped".
+        static std::uint64_t NextGeneration()
+        {
+            static std::atomic< std::uint64_t > counter{ 0 };
+            return counter.fetch_add( 1, std::memory_order_relaxed ) + 1;
+        }
+
+        // The live stamps, and the mutex guarding them.  Function-local
+        // statics dodge initialization-order trouble with owners created
+        // during static construction.
+        static std::unordered_map< const void*, std::uint64_t >& Generations()
+        {
+            static std::unordered_map< const void*, std::uint64_t > map;
+            return map;
+        }
+
+        static std::mutex& MapMutex()
+        {
+            static std::mutex lock;
+            return lock;
+        }
+    };
+}; // End of namespace wbs
+
+#endif // WBS_TP_VALIDATE
+
+#endif // #ifndef _TPVALIDATE_H_
@@ -15,7 +15,14 @@
  */
 #ifndef _UP_H_
 #define _UP_H_
+#include <cstddef>
 #include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "Epoch.h"
+#include "PtrProfile.h"
+#include "TPValidate.h"
 
 /**
  * The Working Bits Systems namespace.
@@ -23,8 +30,36 @@
 namespace wbs
 {
 
-    // Forward declare SP for friend.
-    template< typename TYPESP > class SP;
+    // Forward declare SP for friend.  The second parameter is the threading
+    // policy (see SP.h); the default is supplied where SP is defined.
+    template< typename TYPESP, typename POLICY > class SP;
+
+    /**
+     * Deleters for UP.  The DELETER template parameter decides how the
+     * managed object is destroyed; these two cover the common cases, and
+     * any callable with operator()( TYPE* ) works.  Empty (stateless)
+     * deleters add no size to the UP - it stays a single pointer.
+     */
+    // The default: plain delete, routed through the class's own operator
+    // delete as always.
+    struct DefaultDelete
+    {
+        template< typename TYPE > void operator()( TYPE* p ) const
+        {
+            delete p;
+        }
+    };
+
+    // Does nothing.  For objects whose storage is owned elsewhere - arena
+    // allocations above all (see Arena.h), where the whole region is
+    // released at once and per-object deletes would be pure waste.  Note
+    // that the object's destructor is NOT run either.
+    struct NoDelete
+    {
+        template< typename TYPE > void operator()( TYPE* ) const
+        {
+        }
+    };
 
     /**
      * @class UP
@@ -33,8 +68,13 @@ namespace wbs
      * This class manages ownership of an object of the type passed as the
      * template parameter.  It forces the semantics of the unique owning pointer
      * such that memory will not be leaked.
+     *
+     * The DELETER parameter selects how the object is destroyed (see the
+     * deleters above); stateless deleters occupy no space, so the default
+     * UP remains exactly one pointer wide.
      */
-    template< typename TYPEUP > class UP
+    template< typename TYPEUP, typename DELETER = DefaultDelete > class UP
+    : private DELETER  // Empty-base optimization for stateless deleters.
     {
     public:
         // Constructors, destructor, and Assignment operator -------------------
@@ -49,7 +89,8 @@ namespace wbs
         /**
          * Move semantics constructor.
          */
-        UP( UP< TYPEUP >&& other )
+        UP( UP&& other )
+        : DELETER( static_cast< DELETER&& >( other ) )
         {
              m_ptr = other.m_ptr;
              other.m_ptr = nullptr;
@@ -61,14 +102,54 @@ namespace wbs
         UP( std::unique_ptr< TYPEUP >& other )
         {
              m_ptr = other.release();
+#ifdef WBS_TP_VALIDATE
+             TPValidate::OnCreate( m_ptr );
+#endif
         }
 
         /**
          * Take over ownership from a raw c-style pointer.
+         *
+         * In a WBS_PTR_PROFILE build this adoption is recorded against
+         * the calling file and line (see PtrProfile.h); the extra
+         * defaulted parameter does not change call sites.  In a
+         * WBS_TP_VALIDATE build the object is generation-stamped so TPs
+         * watching it can detect its death (see TPValidate.h).
          */
+#ifdef WBS_PTR_PROFILE
+        UP( TYPEUP* p, PtrProfile::SiteArg site = {} )
+        {
+             m_ptr = p;
+             if ( nullptr != p )
+             {
+                 PtrProfile::RecordAlloc( p, site );
+             }
+#ifdef WBS_TP_VALIDATE
+             TPValidate::OnCreate( p );
+#endif
+        }
+#else
         UP( TYPEUP* p )
         {
              m_ptr = p;
+#ifdef WBS_TP_VALIDATE
+             TPValidate::OnCreate( p );
+#endif
+        }
+#endif
+
+        /**
+         * Take over ownership from a raw c-style pointer, with a deleter
+         * instance.  Only needed for stateful deleters; stateless ones are
+         * simply default-constructed when the time comes.
+         */
+        UP( TYPEUP* p, const DELETER& deleter )
+        : DELETER( deleter )
+        {
+             m_ptr = p;
+#ifdef WBS_TP_VALIDATE
+             TPValidate::OnCreate( p );
+#endif
         }
 
         /**
@@ -79,19 +160,21 @@ namespace wbs
         {
             if ( nullptr != m_ptr )
             {
-                delete m_ptr;
+                DeleteObject();
             }
         }
 
         /**
          * Move semantics assignment operator.
          */
-        UP< TYPEUP >& operator=( UP< TYPEUP >&& other )
+        UP& operator=( UP&& other )
         {
             if ( nullptr != m_ptr )
             {
-                delete m_ptr;
+                DeleteObject();
             }
+            static_cast< DELETER& >( *this ) =
+                static_cast< DELETER&& >( other );
             m_ptr = other.m_ptr;
             other.m_ptr = nullptr;
 
@@ -101,13 +184,16 @@ namespace wbs
         /**
          * Assignment operator for a raw c-style pointer.
          */
-        UP< TYPEUP >& operator=( TYPEUP* p )
+        UP& operator=( TYPEUP* p )
         {
             if ( nullptr != m_ptr )
             {
-                delete m_ptr;
+                DeleteObject();
             }
             m_ptr = p;
+#ifdef WBS_TP_VALIDATE
+            TPValidate::OnCreate( p );
+#endif
 
             return *this;
         }
@@ -141,12 +227,12 @@ namespace wbs
          * @return true if this pointer has the relationship to the rhs as
          *         specified.
          */
-        inline bool operator==( const UP< TYPEUP >& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
-        inline bool operator!=( const UP< TYPEUP >& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
-        inline bool operator<( const UP< TYPEUP >& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
-        inline bool operator<=( const UP< TYPEUP >& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
-        inline bool operator>( const UP< TYPEUP >& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
-        inline bool operator>=( const UP< TYPEUP >& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
+        inline bool operator==( const UP& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
+        inline bool operator!=( const UP& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
+        inline bool operator<( const UP& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
+        inline bool operator<=( const UP& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
+        inline bool operator>( const UP& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
+        inline bool operator>=( const UP& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
 
         // Methods -------------------------------------------------------------
         /**
@@ -157,7 +243,7 @@ namespace wbs
         {
             if ( nullptr != m_ptr )
             {
-                delete m_ptr;
+                DeleteObject();
                 m_ptr = nullptr;
             }
         }
@@ -187,6 +273,26 @@ namespace wbs
         }
 
 
+        /**
+         * Clears the internal pointer WITHOUT deleting the object, returning
+         * the raw pointer to the caller.
+         *
+         * @note This is considered an unsafe operation: ownership of the
+         *       object is handed back to the caller, who becomes responsible
+         *       for its destruction.  Primarily intended for internal use
+         *       where the object's storage is managed by other means (see
+         *       the combined-allocation path in SP.h).
+         *
+         * @return The raw pointer to the (no longer managed) object.
+         */
+        TYPEUP* UnsafeRelease()
+        {
+            TYPEUP* ret = m_ptr;
+            m_ptr = nullptr;
+
+            return ret;
+        }
+
         /**
          * Conversion to std::unique_ptr.
          *
@@ -200,6 +306,11 @@ namespace wbs
          */
         std::unique_ptr< TYPEUP > StdUniquePtr()
         {
+            // unique_ptr would run its own delete; only the matching
+            // deleter can hand over cleanly.
+            static_assert( std::is_same_v< DELETER, DefaultDelete >,
+                           "StdUniquePtr() requires the default deleter." );
+
             std::unique_ptr< TYPEUP > ret( m_ptr );
             m_ptr = nullptr;
 
@@ -212,21 +323,360 @@ namespace wbs
          * Copy constructor disallowed as it would create a second UP that
          * points to the same object.
          */
-        UP< TYPEUP >( const UP< TYPEUP >& );
+        UP( const UP& );
         /**
          * Assignment operator disallowed as it would create a second UP that
          * points to the same object.
          */
-        const UP< TYPEUP >& operator=( const UP< TYPEUP >& );
+        const UP& operator=( const UP& );
+
+        // Deletes the managed object through the deleter - inline normally,
+        // or handed to the epoch reclaimer when epoch mode is on, so
+        // concurrent ReadGuard holders can finish with the object first
+        // (see Epoch.h).  The caller clears m_ptr as appropriate.
+        void DeleteObject()
+        {
+#ifdef WBS_PTR_PROFILE
+            PtrProfile::RecordFree( m_ptr );
+#endif
+            if constexpr ( std::is_empty_v< DELETER > &&
+                           std::is_default_constructible_v< DELETER > )
+            {
+                if ( EpochReclaim::Enabled() )
+                {
+                    // The retirement callback cannot capture, so only a
+                    // stateless deleter (rebuilt inside the callback) can
+                    // defer; stateful ones run inline below.  The
+                    // generation stamp is retired inside the callback too:
+                    // under epoch mode a pinned TP reader may legitimately
+                    // dereference until reclamation actually runs.
+                    EpochReclaim::Retire( m_ptr, []( void* obj )
+                    {
+#ifdef WBS_TP_VALIDATE
+                        TPValidate::OnDestroy( obj );
+#endif
+                        DELETER()( static_cast< TYPEUP* >( obj ) );
+                    } );
+                    return;
+                }
+            }
+
+#ifdef WBS_TP_VALIDATE
+            TPValidate::OnDestroy( m_ptr );
+#endif
+            static_cast< DELETER& >( *this )( m_ptr );
+        }
 
         // Attributes ----------------------------------------------------------
         // The pointer to the object this class manages.
         TYPEUP* m_ptr;
 
         // Friend classes ------------------------------------------------------
-        // Give SP access to clear m_ptr when changing this UP to an SP.
-        friend class SP< TYPEUP >;
+        // Give SP (under any threading policy) access to clear m_ptr when
+        // changing this UP to an SP.
+        template< typename T, typename POLICY > friend class SP;
     };
+
+    /**
+     * @class UP< TYPEUP[] >
+     * The array form: UP< T[] > owns a buffer allocated with new[] and
+     * destroys it with delete[] (the scalar form's delete would be
+     * undefined behavior on an array).  Element access is operator[];
+     * there is no operator-> or operator*, matching the std::unique_ptr
+     * array convention.  The size is NOT tracked - pair with a Span when
+     * the length needs to travel alongside (see Span.h).
+     *
+     * The DELETER parameter works as in the scalar form, except that the
+     * default deleter means delete[] here.  NoDelete works unchanged for
+     * arena-owned buffers.
+     */
+    template< typename TYPEUP, typename DELETER >
+    class UP< TYPEUP[], DELETER >
+    : private DELETER  // Empty-base optimization for stateless deleters.
+    {
+    public:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Default Constructor
+         */
+        UP()
+        {
+            m_ptr = nullptr;
+        }
+
+        /**
+         * Move semantics constructor.
+         */
+        UP( UP&& other )
+        : DELETER( static_cast< DELETER&& >( other ) )
+        {
+             m_ptr = other.m_ptr;
+             other.m_ptr = nullptr;
+        }
+
+        /**
+         * Take over ownership of a buffer from a raw c-style pointer (the
+         * result of new TYPEUP[ n ]).
+         *
+         * In a WBS_PTR_PROFILE build this adoption is recorded against
+         * the calling file and line, like the scalar form's.
+         */
+#ifdef WBS_PTR_PROFILE
+        UP( TYPEUP* p, PtrProfile::SiteArg site = {} )
+        {
+             m_ptr = p;
+             if ( nullptr != p )
+             {
+                 PtrProfile::RecordAlloc( p, site );
+             }
+        }
+#else
+        UP( TYPEUP* p )
+        {
+             m_ptr = p;
+        }
+#endif
+
+        /**
+         * Take over ownership from a raw c-style pointer, with a deleter
+         * instance.  Only needed for stateful deleters; stateless ones are
+         * simply default-constructed when the time comes.
+         */
+        UP( TYPEUP* p, const DELETER& deleter )
+        : DELETER( deleter )
+        {
+             m_ptr = p;
+        }
+
+        /**
+         * Destructor
+         * deletes the referenced buffer if the pointer is initialized.
+         */
+        ~UP()
+        {
+            if ( nullptr != m_ptr )
+            {
+                DeleteObject();
+            }
+        }
+
+        /**
+         * Move semantics assignment operator.
+         */
+        UP& operator=( UP&& other )
+        {
+            if ( nullptr != m_ptr )
+            {
+                DeleteObject();
+            }
+            static_cast< DELETER& >( *this ) =
+                static_cast< DELETER&& >( other );
+            m_ptr = other.m_ptr;
+            other.m_ptr = nullptr;
+
+            return *this;
+        }
+
+        /**
+         * Assignment operator for a raw c-style pointer.
+         */
+        UP& operator=( TYPEUP* p )
+        {
+            if ( nullptr != m_ptr )
+            {
+                DeleteObject();
+            }
+            m_ptr = p;
+
+            return *this;
+        }
+
+        // Operations ----------------------------------------------------------
+        /**
+         * Element access.  No bounds checking; the UP does not know the
+         * buffer's length.
+         *
+         * @param index - the element index.
+         *
+         * @return A reference to the element.
+         */
+        TYPEUP& operator[]( std::size_t index ) const
+        {
+            return m_ptr[ index ];
+        }
+
+        /**
+         * Comparison operators.  Lumping these all together for ease.
+         *
+         * @param rhs - the right-hand-side of the comparison (this is lhs)
+         *
+         * @return true if this pointer has the relationship to the rhs as
+         *         specified.
+         */
+        inline bool operator==( const UP& other ) const { return UnsafeAccess() == other.UnsafeAccess(); }
+        inline bool operator!=( const UP& other ) const { return UnsafeAccess() != other.UnsafeAccess(); }
+        inline bool operator<( const UP& other ) const  { return UnsafeAccess() < other.UnsafeAccess(); }
+        inline bool operator<=( const UP& other ) const { return UnsafeAccess() <= other.UnsafeAccess(); }
+        inline bool operator>( const UP& other ) const  { return UnsafeAccess() > other.UnsafeAccess(); }
+        inline bool operator>=( const UP& other ) const { return UnsafeAccess() >= other.UnsafeAccess(); }
+
+        // Methods -------------------------------------------------------------
+        /**
+         * Deletes the buffer this UP points to and clears the pointer
+         * (sets to nullptr).
+         */
+        void Delete()
+        {
+            if ( nullptr != m_ptr )
+            {
+                DeleteObject();
+                m_ptr = nullptr;
+            }
+        }
+
+        /**
+         * Checks if the internal pointer is null.
+         *
+         * @return true is the internal pointer is nullptr, otherwise false.
+         */
+        bool IsNull() const
+        {
+            return ( nullptr == m_ptr );
+        }
+
+        /**
+         * Pointer access.
+         *
+         * @note This is considered an unsafe operation and should be avoided.
+         *       Possible exceptions include passing a TEMPORARY pointer to
+         *       a system or third party function/method.
+         *
+         * @return The raw pointer to the buffer.
+         */
+        TYPEUP* UnsafeAccess() const
+        {
+            return m_ptr;
+        }
+
+        /**
+         * Clears the internal pointer WITHOUT deleting the buffer,
+         * returning the raw pointer to the caller.
+         *
+         * @note This is considered an unsafe operation: ownership of the
+         *       buffer is handed back to the caller, who becomes
+         *       responsible for its destruction (with delete[]).
+         *
+         * @return The raw pointer to the (no longer managed) buffer.
+         */
+        TYPEUP* UnsafeRelease()
+        {
+            TYPEUP* ret = m_ptr;
+            m_ptr = nullptr;
+
+            return ret;
+        }
+
+    private:
+        // Constructors, destructor, and Assignment operator -------------------
+        /**
+         * Copy constructor disallowed as it would create a second UP that
+         * points to the same buffer.
+         */
+        UP( const UP& );
+        /**
+         * Assignment operator disallowed as it would create a second UP that
+         * points to the same buffer.
+         */
+        const UP& operator=( const UP& );
+
+        // Deletes the managed buffer - with delete[] under the default
+        // deleter, through the deleter otherwise - inline normally, or
+        // handed to the epoch reclaimer when epoch mode is on, exactly as
+        // in the scalar form.
+        void DeleteObject()
+        {
+#ifdef WBS_PTR_PROFILE
+            PtrProfile::RecordFree( m_ptr );
+#endif
+            if constexpr ( std::is_same_v< DELETER, DefaultDelete > )
+            {
+                if ( EpochReclaim::Enabled() )
+                {
+                    EpochReclaim::Retire( m_ptr, []( void* arr )
+                    {
+                        delete[] static_cast< TYPEUP* >( arr );
+                    } );
+                    return;
+                }
+
+                delete[] m_ptr;
+            }
+            else
+            {
+                if constexpr ( std::is_empty_v< DELETER > &&
+                               std::is_default_constructible_v< DELETER > )
+                {
+                    if ( EpochReclaim::Enabled() )
+                    {
+                        EpochReclaim::Retire( m_ptr, []( void* arr )
+                        {
+                            DELETER()( static_cast< TYPEUP* >( arr ) );
+                        } );
+                        return;
+                    }
+                }
+
+                static_cast< DELETER& >( *this )( m_ptr );
+            }
+        }
+
+        // Attributes ----------------------------------------------------------
+        // The pointer to the buffer this class manages.
+        TYPEUP* m_ptr;
+
+        // Friend classes ------------------------------------------------------
+        // Give SP (under any threading policy) access to clear m_ptr when
+        // changing this UP to an SP (see SP's array form).
+        template< typename T, typename POLICY > friend class SP;
+    };
+
+    /**
+     * Creates a UP for a newly constructed object, perfect-forwarding the
+     * passed arguments to the object's constructor.  This removes the
+     * raw-pointer temporary that UP< T > p( new T( ... ) ) forces on the
+     * call site; the pointer goes straight into the managed slot without
+     * ever being visible.  The allocation still happens through new, so a
+     * class's own operator new (e.g. a MemCache) fires as usual.
+     *
+     * @param args - the arguments to forward to TYPEUP's constructor.
+     *
+     * @return A UP owning the newly constructed object.
+     */
+    template< typename TYPEUP, typename... ARGS >
+    std::enable_if_t< !std::is_array_v< TYPEUP >, UP< TYPEUP > >
+    MakeUP( ARGS&&... args )
+    {
+        return UP< TYPEUP >( new TYPEUP( std::forward< ARGS >( args )... ) );
+    }
+
+    /**
+     * The array form: creates a UP< T[] > owning count value-initialized
+     * elements, allocated as ONE block with new[] (through the class's
+     * own operator new[] when it provides one, as always).
+     *
+     * Usage: UP< char[] > buffer = MakeUP< char[] >( 4096 );
+     *
+     * @param count - the number of elements to allocate.
+     *
+     * @return A UP owning the new buffer.
+     */
+    template< typename TYPEUP >
+    std::enable_if_t< std::is_array_v< TYPEUP >, UP< TYPEUP > >
+    MakeUP( std::size_t count )
+    {
+        return UP< TYPEUP >(
+            new std::remove_extent_t< TYPEUP >[ count ]() );
+    }
 }; // End of namespace wbs
 
 #endif // #ifndef _UP_H_
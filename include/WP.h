@@ -31,9 +31,21 @@ namespace wbs
      * internal object that points to the shared object.  If the shared pointers
      * on this object go out of scope, the weak pointer can recognize this, and
      * signal that the pointer is no longer usable.
+     *
+     * The POLICYWP parameter is the threading policy, matching the policy of
+     * the SPs this WP tracks (see SP.h).  The default (MultiThreaded) is
+     * supplied on the forward declaration in SP.h.
      */
-    template< typename TYPEWP > class WP
+    template< typename TYPEWP, typename POLICYWP > class WP
     {
+        // Intrusive (RefCounted) classes have no life beyond their object -
+        // the count dies with it - so there is nothing for a weak pointer to
+        // safely interrogate.  Refuse at compile time rather than dangle.
+        static_assert( !SP< TYPEWP, POLICYWP >::IS_INTRUSIVE,
+                       "WP is not supported for RefCounted (intrusive) "
+                       "classes; the reference count does not outlive the "
+                       "object." );
+
     public:
         // Constructors, destructor, and Assignment operator -------------------
         /**
@@ -42,6 +54,7 @@ namespace wbs
         WP()
         {
             m_internalObject = nullptr;
+            m_objectPtr = nullptr;
         }
 
         /**
@@ -49,9 +62,10 @@ namespace wbs
          *
          * @param p - the SP to an object of type TYPEWP.
          */
-        WP( const SP< TYPEWP >& p )
+        WP( const SP< TYPEWP, POLICYWP >& p )
         {
             m_internalObject = p.m_internalObject;
+            m_objectPtr = p.m_objectPtr;
 
             if ( nullptr != m_internalObject )
             {
@@ -77,9 +91,10 @@ namespace wbs
          *
          * @param other -The other WP to also track the object without ownership
          */
-        WP( const WP< TYPEWP >& other )
+        WP( const WP< TYPEWP, POLICYWP >& other )
         {
             m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
             if ( nullptr != m_internalObject )
             {
                 m_internalObject->AddWeakRef();
@@ -92,13 +107,15 @@ namespace wbs
          * @param other - The other WP to pass ownership of the embedded object
          *                with.
          */
-        WP( WP< TYPEWP >&& other )
+        WP( WP< TYPEWP, POLICYWP >&& other )
         {
             // Move the internal reference object and clear the passed
             // reference.  We can ignore reference counts as it'll be a
             // remove one followed by an add one.  Net zero.
             m_internalObject = other.m_internalObject;
+            m_objectPtr = other.m_objectPtr;
             other.m_internalObject = nullptr;
+            other.m_objectPtr = nullptr;
         }
 
         /**
@@ -108,25 +125,33 @@ namespace wbs
          *
          * @return The reference to this pointer.
          */
-        WP& operator=( const WP< TYPEWP >& other )
+        WP& operator=( const WP< TYPEWP, POLICYWP >& other )
         {
-            // Skip self-assignment and assignment to the same internal object.
-            if ( ( &other != this ) &&
-                 ( other.m_internalObject != m_internalObject ) )
+            // Skip self-assignment.
+            if ( &other != this )
             {
-                // If we were already pointing to an object, decrement the
-                // reference to it.
-                if ( nullptr != m_internalObject )
+                // Counts only change when the internal object does; aliased
+                // SPs can share a count block yet reference different
+                // sub-objects, so the object pointer is always copied.
+                if ( other.m_internalObject != m_internalObject )
                 {
-                    m_internalObject->DecWeakRef();
-                }
+                    // If we were already pointing to an object, decrement
+                    // the reference to it.
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->DecWeakRef();
+                    }
 
-                // Assign the internal pointer and increment the reference.
-                m_internalObject = other.m_internalObject;
-                if ( nullptr != m_internalObject )
-                {
-                    m_internalObject->AddWeakRef();
+                    // Assign the internal pointer and increment the
+                    // reference.
+                    m_internalObject = other.m_internalObject;
+                    if ( nullptr != m_internalObject )
+                    {
+                        m_internalObject->AddWeakRef();
+                    }
                 }
+
+                m_objectPtr = other.m_objectPtr;
             }
 
             return *this;
@@ -140,7 +165,7 @@ namespace wbs
          *
          * @return The reference to this pointer.
          */
-        WP& operator=( WP< TYPEWP >&& other )
+        WP& operator=( WP< TYPEWP, POLICYWP >&& other )
         {
             // Skip self-assignment and assignment to the same internal object.
             if ( &other != this )
@@ -155,9 +180,11 @@ namespace wbs
                 // Assign the internal pointer.  We can ignore reference counts
                 // as it'll be a remove one followed by an add one.  Net zero.
                 m_internalObject = other.m_internalObject;
+                m_objectPtr = other.m_objectPtr;
 
                 // Clear the input SP's internal pointer.
                 other.m_internalObject = nullptr;
+                other.m_objectPtr = nullptr;
             }
 
             return *this;
@@ -173,7 +200,7 @@ namespace wbs
          *
          * @return The reference to this pointer.
          */
-        WP& operator=( const SP< TYPEWP >& p )
+        WP& operator=( const SP< TYPEWP, POLICYWP >& p )
         {
             if ( nullptr != m_internalObject )
             {
@@ -181,6 +208,7 @@ namespace wbs
             }
 
             m_internalObject = p.m_internalObject;
+            m_objectPtr = p.m_objectPtr;
 
             if ( nullptr != m_internalObject )
             {
@@ -199,9 +227,10 @@ namespace wbs
          *         that this SP may be a null pointer, and should be checked
          *         before use.
          */
-        SP< TYPEWP > GetSP()
+        SP< TYPEWP, POLICYWP > GetSP()
         {
-            return std::move( SP< TYPEWP >( m_internalObject ) );
+            return std::move(
+                SP< TYPEWP, POLICYWP >( m_internalObject, m_objectPtr ) );
         }
 
         /**
@@ -213,6 +242,7 @@ namespace wbs
             {
                 m_internalObject->DecWeakRef();
                 m_internalObject = nullptr;
+                m_objectPtr = nullptr;
             }
         }
 
@@ -229,7 +259,44 @@ namespace wbs
         bool IsNull()
         {
             return ( ( nullptr == m_internalObject ) ||
-                     ( nullptr == m_internalObject->GetPtr() ) );
+                     ( 0 == m_internalObject->StrongCount() ) );
+        }
+
+        /**
+         * Determines whether the tracked object has been destroyed.  This is
+         * a single relaxed load of the shared count - no pointer chasing -
+         * so it is cheap enough to call in bulk, e.g. when sweeping a large
+         * table of WPs for dead entries.
+         *
+         * @return true if the object is gone (or this WP tracks nothing),
+         *         false if at least one SP still holds it.
+         *
+         * @note As with IsNull(), a false answer can go stale immediately;
+         *       promote with GetSP() and check that before actually using
+         *       the object.  A true answer is final: the object cannot come
+         *       back.
+         */
+        bool Expired() const
+        {
+            return ( ( nullptr == m_internalObject ) ||
+                     ( 0 == m_internalObject->StrongCount() ) );
+        }
+
+        /**
+         * The number of SPs currently sharing the tracked object.
+         *
+         * @return The shared reference count, or 0 if the object is gone or
+         *         this WP tracks nothing.
+         *
+         * @note A snapshot only - the count can change before the caller
+         *       acts on it.  Intended for statistics and heuristics (cache
+         *       eviction scoring and the like), not for lifetime decisions.
+         */
+        std::uint32_t UseCount() const
+        {
+            return ( ( nullptr == m_internalObject )
+                     ? 0
+                     : m_internalObject->StrongCount() );
         }
 
     private:
@@ -239,8 +306,13 @@ namespace wbs
         // The internal object that all of the shared pointers for this object
         // use to keep track of the object itself ands the count of existing
         // SPs.  It handles deleting itself if the count of holding SPs goes to
-        // zero.
-        typename SP< TYPEWP >::InternalObject* m_internalObject;
+        // zero.  Held through the type-erased ControlBlock base, matching SP.
+        ControlBlock< POLICYWP >* m_internalObject;
+
+        // The object pointer captured from the SP, handed back on promotion
+        // so an SP made from this WP dereferences to the same (possibly
+        // aliased) sub-object.  Only valid while the object exists.
+        TYPEWP* m_objectPtr;
     };
 }; // End of namespace wbs
 
@@ -0,0 +1,366 @@
+/**
+ * SmartPointers_bench.cpp
+ *
+ * Abstract:
+ * A repeatable benchmark suite for the wbs pointers, so releases can be
+ * gated on measured numbers instead of ad-hoc timing.  Each benchmark
+ * times many samples of a fixed-size operation loop (after warmup) and
+ * reports the median and p99 nanoseconds per operation, head-to-head
+ * with the standard library equivalent:
+ *
+ *   - UP create/destroy       vs std::unique_ptr
+ *   - SP copy/destroy         vs std::shared_ptr
+ *   - WP::GetSP() promotion   vs std::weak_ptr::lock()
+ *   - MemCache-backed new     vs plain new
+ *
+ * Every pairing runs single-threaded and again with N threads hammering
+ * it concurrently.  Output is a human-readable table by default, or
+ * machine-readable with --json or --csv for CI gating.
+ *
+ * Usage: SmartPointers_bench [--iters N] [--samples N] [--threads N]
+ *                            [--json | --csv]
+ *
+ * @see SmartPointers_test.cpp MemCache.h
+ *
+ * @copyright Copyright(C) Working Bits Systems, LLC 2023
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/SmartPointers.h"
+
+using namespace wbs;
+
+//**************************** Harness *************************************
+
+// Keeps the optimizer from deleting a benchmarked operation whose result
+// is otherwise unused.
+template< typename TYPE >
+static inline void DoNotOptimize( TYPE const& value )
+{
+    asm volatile( "" : : "r,m"( value ) : "memory" );
+}
+
+// One benchmark's numbers, already reduced to ns-per-op.
+struct BenchResult
+{
+    std::string m_name;
+    int         m_threads;
+    double      m_medianNs;
+    double      m_p99Ns;
+};
+
+// The run configuration, from the command line.
+struct BenchConfig
+{
+    int  m_iters = 10000;   // Operations per timed sample.
+    int  m_samples = 50;    // Timed samples per thread.
+    int  m_threads = 4;     // Thread count for the contended runs.
+    bool m_json = false;
+    bool m_csv = false;
+};
+
+// Returns the value at the given percentile (0-100) of the sorted samples.
+static double Percentile( std::vector< double >& samples, double pct )
+{
+    std::sort( samples.begin(), samples.end() );
+    std::size_t index = static_cast< std::size_t >(
+        ( pct / 100.0 ) * static_cast< double >( samples.size() - 1 ) + 0.5 );
+
+    return samples[ index ];
+}
+
+/**
+ * Runs one benchmark: warms the operation up, then times the configured
+ * number of samples of the configured number of operations on each of
+ * the requested threads, and reduces all the per-sample ns-per-op
+ * figures to a median and a p99.
+ *
+ * @param name    - the benchmark's reporting name.
+ * @param config  - the run configuration.
+ * @param threads - how many threads run the loop concurrently.
+ * @param op      - the operation under test; called once per iteration.
+ *
+ * @return The reduced result.
+ */
+template< typename OP >
+static BenchResult RunBench( const std::string& name,
+                             const BenchConfig& config,
+                             int threads,
+                             OP op )
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector< std::vector< double > > perThread( threads );
+    std::atomic< int > ready( 0 );
+    std::atomic< bool > go( false );
+
+    auto worker = [ & ]( int thread )
+    {
+        perThread[ thread ].reserve( config.m_samples );
+
+        // Warmup: a few untimed samples to fault in caches and settle
+        // the thread-local allocator state.
+        for ( int i = 0; i < config.m_iters * 3; ++i )
+        {
+            op();
+        }
+
+        // Start all the threads' timed samples together, so the
+        // contended runs actually contend.
+        ++ready;
+        while ( !go.load( std::memory_order_acquire ) )
+        {
+            std::this_thread::yield();
+        }
+
+        for ( int sample = 0; sample < config.m_samples; ++sample )
+        {
+            Clock::time_point start = Clock::now();
+            for ( int i = 0; i < config.m_iters; ++i )
+            {
+                op();
+            }
+            Clock::time_point stop = Clock::now();
+
+            perThread[ thread ].push_back(
+                std::chrono::duration< double, std::nano >( stop - start )
+                    .count() / config.m_iters );
+        }
+    };
+
+    std::vector< std::thread > pool;
+    for ( int thread = 0; thread < threads; ++thread )
+    {
+        pool.push_back( std::thread( worker, thread ) );
+    }
+    while ( ready.load() < threads )
+    {
+        std::this_thread::yield();
+    }
+    go.store( true, std::memory_order_release );
+    for ( auto& thread : pool )
+    {
+        thread.join();
+    }
+
+    std::vector< double > samples;
+    for ( auto& threadSamples : perThread )
+    {
+        samples.insert( samples.end(),
+                        threadSamples.begin(), threadSamples.end() );
+    }
+
+    BenchResult result;
+    result.m_name = name;
+    result.m_threads = threads;
+    result.m_medianNs = Percentile( samples, 50.0 );
+    result.m_p99Ns = Percentile( samples, 99.0 );
+
+    return result;
+}
+
+//**************************** Subjects ************************************
+
+// The payload for the pointer benchmarks: big enough not to be trivially
+// foldable, small enough to stay allocator-bound.
+class Payload
+{
+public:
+    Payload()
+    {
+        m_a = 1;
+        m_b = 2;
+    }
+
+    int m_a;
+    int m_b;
+    char m_pad[ 48 ];
+};
+
+// The same payload, but allocated through MemCache.
+class CachedPayload : public MemCache< CachedPayload >
+{
+public:
+    CachedPayload()
+    {
+        m_a = 1;
+        m_b = 2;
+    }
+
+    int m_a;
+    int m_b;
+    char m_pad[ 48 ];
+};
+
+//**************************** Benchmarks **********************************
+
+// Registers every pairing at the given thread count.
+static void RunAll( const BenchConfig& config,
+                    int threads,
+                    std::vector< BenchResult >& results )
+{
+    // UP create/destroy vs std::unique_ptr.
+    results.push_back( RunBench( "UP_create_destroy", config, threads, []()
+    {
+        UP< Payload > p = MakeUP< Payload >();
+        DoNotOptimize( p.UnsafeAccess() );
+    } ) );
+    results.push_back( RunBench( "unique_ptr_create_destroy", config,
+                                 threads, []()
+    {
+        std::unique_ptr< Payload > p = std::make_unique< Payload >();
+        DoNotOptimize( p.get() );
+    } ) );
+
+    // SP copy/destroy vs std::shared_ptr.  Each thread copies its own
+    // source pointer - contention here is the allocator and the counts,
+    // not one globally shared object.
+    results.push_back( RunBench( "SP_copy_destroy", config, threads, []()
+    {
+        static thread_local SP< Payload > source =
+            MakeSP< Payload >();
+        SP< Payload > copy( source );
+        DoNotOptimize( copy.UnsafeAccess() );
+    } ) );
+    results.push_back( RunBench( "shared_ptr_copy_destroy", config,
+                                 threads, []()
+    {
+        static thread_local std::shared_ptr< Payload > source =
+            std::make_shared< Payload >();
+        std::shared_ptr< Payload > copy( source );
+        DoNotOptimize( copy.get() );
+    } ) );
+
+    // WP promotion vs std::weak_ptr::lock.
+    results.push_back( RunBench( "WP_GetSP", config, threads, []()
+    {
+        static thread_local SP< Payload > owner =
+            MakeSP< Payload >();
+        static thread_local WP< Payload > weak( owner );
+        SP< Payload > promoted = weak.GetSP();
+        DoNotOptimize( promoted.UnsafeAccess() );
+    } ) );
+    results.push_back( RunBench( "weak_ptr_lock", config, threads, []()
+    {
+        static thread_local std::shared_ptr< Payload > owner =
+            std::make_shared< Payload >();
+        static thread_local std::weak_ptr< Payload > weak( owner );
+        std::shared_ptr< Payload > promoted = weak.lock();
+        DoNotOptimize( promoted.get() );
+    } ) );
+
+    // MemCache-backed new/delete vs plain new/delete.
+    results.push_back( RunBench( "MemCache_new_delete", config, threads, []()
+    {
+        CachedPayload* p = new CachedPayload();
+        DoNotOptimize( p );
+        delete p;
+    } ) );
+    results.push_back( RunBench( "plain_new_delete", config, threads, []()
+    {
+        Payload* p = new Payload();
+        DoNotOptimize( p );
+        delete p;
+    } ) );
+}
+
+//**************************** Reporting ***********************************
+
+static void Report( const BenchConfig& config,
+                    const std::vector< BenchResult >& results )
+{
+    if ( config.m_json )
+    {
+        std::printf( "[\n" );
+        for ( std::size_t i = 0; i < results.size(); ++i )
+        {
+            const BenchResult& r = results[ i ];
+            std::printf( "  { \"name\": \"%s\", \"threads\": %d, "
+                         "\"median_ns\": %.2f, \"p99_ns\": %.2f }%s\n",
+                         r.m_name.c_str(), r.m_threads,
+                         r.m_medianNs, r.m_p99Ns,
+                         ( i + 1 < results.size() ) ? "," : "" );
+        }
+        std::printf( "]\n" );
+    }
+    else if ( config.m_csv )
+    {
+        std::printf( "name,threads,median_ns,p99_ns\n" );
+        for ( const BenchResult& r : results )
+        {
+            std::printf( "%s,%d,%.2f,%.2f\n",
+                         r.m_name.c_str(), r.m_threads,
+                         r.m_medianNs, r.m_p99Ns );
+        }
+    }
+    else
+    {
+        std::printf( "%-28s %8s %12s %12s\n",
+                     "benchmark", "threads", "median ns/op", "p99 ns/op" );
+        for ( const BenchResult& r : results )
+        {
+            std::printf( "%-28s %8d %12.2f %12.2f\n",
+                         r.m_name.c_str(), r.m_threads,
+                         r.m_medianNs, r.m_p99Ns );
+        }
+    }
+}
+
+//**************************** Main ****************************************
+
+int main( int argc, char** argv )
+{
+    BenchConfig config;
+
+    for ( int arg = 1; arg < argc; ++arg )
+    {
+        if ( ( 0 == std::strcmp( argv[ arg ], "--iters" ) )
+             && ( ( arg + 1 ) < argc ) )
+        {
+            config.m_iters = std::atoi( argv[ ++arg ] );
+        }
+        else if ( ( 0 == std::strcmp( argv[ arg ], "--samples" ) )
+                  && ( ( arg + 1 ) < argc ) )
+        {
+            config.m_samples = std::atoi( argv[ ++arg ] );
+        }
+        else if ( ( 0 == std::strcmp( argv[ arg ], "--threads" ) )
+                  && ( ( arg + 1 ) < argc ) )
+        {
+            config.m_threads = std::atoi( argv[ ++arg ] );
+        }
+        else if ( 0 == std::strcmp( argv[ arg ], "--json" ) )
+        {
+            config.m_json = true;
+        }
+        else if ( 0 == std::strcmp( argv[ arg ], "--csv" ) )
+        {
+            config.m_csv = true;
+        }
+        else
+        {
+            std::fprintf( stderr,
+                          "usage: %s [--iters N] [--samples N] "
+                          "[--threads N] [--json | --csv]\n", argv[ 0 ] );
+
+            return 1;
+        }
+    }
+
+    std::vector< BenchResult > results;
+    RunAll( config, 1, results );
+    RunAll( config, config.m_threads, results );
+
+    Report( config, results );
+
+    return 0;
+}
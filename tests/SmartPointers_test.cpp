@@ -5,9 +5,11 @@
 #include <vector>
 #include <memory>
 
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <cmath>
+#include <thread>
 
 #include "../include/SmartPointers.h"
 
@@ -25,6 +27,14 @@ public:
        if ( output ) std::cout << "Add new TestPtr object, new total = " << total << std:: endl;
    }
 
+   // The copy counts as an object too; the CowP tests clone through this.
+   TestPtr( const TestPtr& other )
+   : a( other.a ), b( other.b )
+   {
+       ++total;
+       if ( output ) std::cout << "Copied TestPtr object, new total = " << total << std:: endl;
+   }
+
    ~TestPtr()
    {
        if ( output ) std::cout << "Destroyed TestPtr with a = " << a << ", b = " << b << std::endl;
@@ -35,10 +45,12 @@ public:
    int a;
    int b;
 
-   static int total;
+   // Atomic: the PtrQueue tests create and destroy TestPtrs on
+   // different threads at once.
+   static std::atomic< int > total;
    static bool output;
 };
-int TestPtr::total = 0;
+std::atomic< int > TestPtr::total( 0 );
 bool TestPtr::output = true;
 
 class TestAlloc
@@ -67,6 +79,135 @@ private:
     std::uint64_t bigint2;
 };
 
+// A MemCache-backed class for exercising the cache APIs directly.
+class TestCached
+: public MemCache< TestCached >
+{
+public:
+    TestCached( int x )
+    : v( x )
+    {
+    }
+
+    int v;
+};
+
+// A cache-line-aligned cached class, as a contention-heavy class would
+// declare itself; every allocation must land on its own line.
+class TestAligned
+: public MemCache< TestAligned, CACHE_LINE_SIZE >
+{
+public:
+    TestAligned( int x )
+    : v( x )
+    {
+    }
+
+    int v;
+};
+
+// A larger class sharing TestCached's cache, to exercise the size-class
+// buckets: its blocks must be recycled separately from TestCached's.
+class TestCachedBig
+: public TestCached
+{
+public:
+    TestCachedBig( int x )
+    : TestCached( x )
+    {
+        for ( int i = 0; i < 16; ++i )
+        {
+            pad[ i ] = x + i;
+        }
+    }
+
+    int pad[ 16 ];
+};
+
+// A trivially destructible class for arena tests; arenas release storage
+// without running destructors.
+struct TestArenaObj
+{
+    TestArenaObj( int x, int y )
+    : a( x ), b( y )
+    {
+    }
+
+    int a;
+    int b;
+};
+
+// A class carrying its own reference count, for the intrusive SP mode.
+class TestIntrusive
+: public RefCounted< TestIntrusive >
+{
+public:
+    static inline int total = 0;
+
+    TestIntrusive( int x )
+    : v( x )
+    {
+        ++total;
+    }
+
+    ~TestIntrusive()
+    {
+        --total;
+    }
+
+    int v;
+};
+
+// A class with an expensive-construction shape for the ObjectPool tests:
+// the counters tell recycling (pop + Reset) apart from reconstruction.
+class TestPooled
+{
+public:
+    static inline int constructs = 0;
+    static inline int destructs = 0;
+    static inline int resets = 0;
+
+    TestPooled()
+    {
+        ++constructs;
+        m_state = -1;
+    }
+
+    ~TestPooled()
+    {
+        ++destructs;
+    }
+
+    void Reset()
+    {
+        ++resets;
+        m_state = 0;
+    }
+
+    int m_state;
+};
+
+// A counting class for the array forms: delete[] must run every
+// element's destructor.
+class TestArrayObj
+{
+public:
+    static inline int constructs = 0;
+    static inline int destructs = 0;
+
+    TestArrayObj()
+    {
+        ++constructs;
+    }
+
+    ~TestArrayObj()
+    {
+        ++destructs;
+    }
+
+    int m_value = 0;
+};
+
 void testfunc( UP< TestPtr > p )
 {
     // Transfer the UP using the assignment operator with move semantics.
@@ -468,6 +609,24 @@ int main( int argc, char** argv )
         assert( sw1.IsNull() );
         assert( 1 == TestPtr::total );
 
+        // Expired() and UseCount() - the one-load liveness check.
+        SP<TestPtr> swx( new TestPtr( 57, 60 ) );
+        WP< TestPtr > wx( swx );
+        assert( !wx.Expired() );
+        assert( 1 == wx.UseCount() );
+        {
+            SP<TestPtr> swx2( swx );
+            assert( 2 == wx.UseCount() );
+        }
+        assert( 1 == wx.UseCount() );
+        swx.Delete();
+        assert( wx.Expired() );
+        assert( 0 == wx.UseCount() );
+        wx.Drop();
+        assert( wx.Expired() );
+        assert( 0 == wx.UseCount() );
+        assert( w0.Expired() );
+
         // Assignment from SP
         SP<TestPtr> sw2( new TestPtr( 52, 55 ) );
         WP< TestPtr > w2;
@@ -563,6 +722,994 @@ int main( int argc, char** argv )
         assert( 1 == TestPtr::total );
 
 
+        //*********************** MakeUP Tests *****************************
+        // Factory construction with forwarded arguments - no raw pointer at
+        // the call site.
+        UP< TestPtr > mup1 = MakeUP< TestPtr >( 61, 62 );
+        assert( !mup1.IsNull() );
+        assert( 61 == mup1->a );
+        assert( 62 == mup1->b );
+        assert( 2 == TestPtr::total );
+        mup1.Delete();
+        assert( 1 == TestPtr::total );
+
+        //*********************** MakeSP Tests *****************************
+        // Single-allocation construction with forwarded arguments.
+        SP< TestPtr > ms1 = MakeSP< TestPtr >( 71, 72 );
+        assert( !ms1.IsNull() );
+        assert( 71 == ms1->a );
+        assert( 72 == ms1->b );
+        assert( 2 == TestPtr::total );
+
+        // Copies share the combined block like any other SP.
+        SP< TestPtr > ms2( ms1 );
+        assert( ms1.UnsafeAccess() == ms2.UnsafeAccess() );
+        ms2.Delete();
+        assert( 2 == TestPtr::total );
+
+        // A weak pointer may outlive the object; the combined block is only
+        // freed when the last weak reference drops.
+        WP< TestPtr > mw1( ms1 );
+        ms1.Delete();
+        assert( mw1.IsNull() );
+        assert( 1 == TestPtr::total );
+        mw1.Drop();
+
+        // MakeSP through a class that overrides new/delete: the single
+        // combined allocation goes through the class's own operators (watch
+        // the TestAlloc output - one allocation, one delete).
+        {
+            std::cout << "Allocation using MakeSP" << std::endl;
+            SP< TestAlloc > msa = MakeSP< TestAlloc >();
+            assert( !msa.IsNull() );
+        }
+
+        //*********************** MemCache Tests ***************************
+        // Pre-warm the cache, then allocate and free through it.
+        TestCached::Reserve( 8 );
+        {
+            TestCached* tc = new TestCached( 5 );
+            assert( 5 == tc->v );
+            delete tc;
+
+            std::vector< TestCached* > cachedObjs;
+            for ( int i = 0; i < 20; ++i )
+            {
+                cachedObjs.push_back( new TestCached( i ) );
+            }
+            for ( int i = 0; i < 20; ++i )
+            {
+                assert( i == cachedObjs[ i ]->v );
+                delete cachedObjs[ i ];
+            }
+
+            // Interleave two sizes through the shared hierarchy cache; each
+            // must come back from its own size bucket intact.
+            for ( int round = 0; round < 10; ++round )
+            {
+                TestCached*    small = new TestCached( round );
+                TestCachedBig* big   = new TestCachedBig( round + 100 );
+                assert( round == small->v );
+                assert( round + 100 == big->v );
+                for ( int i = 0; i < 16; ++i )
+                {
+                    assert( round + 100 + i == big->pad[ i ] );
+                }
+                delete small;
+                delete big;
+            }
+
+            // The aligned mode: every block - freshly carved or recycled -
+            // starts on its own cache line.
+            std::vector< TestAligned* > alignedObjs;
+            for ( int i = 0; i < 20; ++i )
+            {
+                alignedObjs.push_back( new TestAligned( i ) );
+                assert( 0 == ( reinterpret_cast< std::uintptr_t >(
+                                   alignedObjs.back() )
+                               % CACHE_LINE_SIZE ) );
+            }
+            for ( int i = 0; i < 20; ++i )
+            {
+                assert( i == alignedObjs[ i ]->v );
+                delete alignedObjs[ i ];
+            }
+            for ( int i = 0; i < 20; ++i )
+            {
+                TestAligned* recycled = new TestAligned( i + 50 );
+                assert( 0 == ( reinterpret_cast< std::uintptr_t >( recycled )
+                               % CACHE_LINE_SIZE ) );
+                assert( i + 50 == recycled->v );
+                delete recycled;
+            }
+        }
+
+#ifdef WBS_MEMCACHE_STATS
+        // With stats compiled in, the counters and registry are live.
+        {
+            MemCacheStats stats = TestCached::Stats();
+            assert( 0 < stats.m_missCount );
+            assert( 0 < stats.m_hitCount );
+            assert( 0 < stats.m_cacheSize );
+            assert( 0 < stats.m_bytesRetained );
+            assert( 0 < stats.m_inUseHighWater );
+            assert( !MemCacheRegistry::Entries().empty() );
+        }
+#endif
+
+        //****************** SingleThreaded policy Tests *******************
+        // Same behavior as the default policy, minus the atomics.  These
+        // pointers must never leave the thread that created them.
+        SP< TestPtr, SingleThreaded > st1( new TestPtr( 81, 82 ) );
+        assert( !st1.IsNull() );
+        assert( 81 == st1->a );
+        assert( 2 == TestPtr::total );
+
+        SP< TestPtr, SingleThreaded > st2( st1 );
+        assert( st1.UnsafeAccess() == st2.UnsafeAccess() );
+        assert( 2 == TestPtr::total );
+
+        WP< TestPtr, SingleThreaded > stw1( st1 );
+        assert( !stw1.IsNull() );
+
+        TP< TestPtr > stt1( st1 );
+        assert( 81 == stt1->a );
+
+        // The factory honors the policy as well.
+        SP< TestPtr, SingleThreaded > st3 =
+            MakeSP< TestPtr, SingleThreaded >( 83, 84 );
+        assert( 83 == st3->a );
+        assert( 3 == TestPtr::total );
+        st3.Delete();
+
+        st2.Delete();
+        assert( 2 == TestPtr::total );
+        st1.Delete();
+        assert( stw1.IsNull() );
+        stw1.Drop();
+        assert( 1 == TestPtr::total );
+
+        //****************** BiasedThreaded policy Tests *******************
+        // The creating thread counts its references without atomics while
+        // foreign threads share the object through the atomic count.  A
+        // reference taken on the owning thread is released there too.
+        {
+            SP< TestPtr, BiasedThreaded > bt1( new TestPtr( 85, 86 ) );
+            assert( !bt1.IsNull() );
+            assert( 85 == bt1->a );
+            assert( 2 == TestPtr::total );
+
+            // Owner-thread copies ride the unsynchronized count.
+            SP< TestPtr, BiasedThreaded > bt2( bt1 );
+            assert( bt1.UnsafeAccess() == bt2.UnsafeAccess() );
+            assert( 2 == TestPtr::total );
+
+            // Weak pointers and the factory honor the policy as well.
+            WP< TestPtr, BiasedThreaded > btw1( bt1 );
+            assert( !btw1.IsNull() );
+
+            SP< TestPtr, BiasedThreaded > bt3 =
+                MakeSP< TestPtr, BiasedThreaded >( 87, 88 );
+            assert( 87 == bt3->a );
+            assert( 3 == TestPtr::total );
+            bt3.Delete();
+            assert( 2 == TestPtr::total );
+
+            // A foreign thread shares the object through copies of its
+            // own, each taken and released on that thread.
+            std::thread sharer( [ &bt1 ]()
+            {
+                for ( int i = 0; i < 10000; ++i )
+                {
+                    SP< TestPtr, BiasedThreaded > copy( bt1 );
+                    assert( 85 == copy->a );
+                }
+            } );
+            sharer.join();
+            assert( 2 == TestPtr::total );
+
+            // The owner releases last here: its biased count merges away
+            // and the object dies exactly once.
+            bt2.Delete();
+            assert( 2 == TestPtr::total );
+            bt1.Delete();
+            assert( btw1.IsNull() );
+            btw1.Drop();
+            assert( 1 == TestPtr::total );
+
+            // The other order: a foreign copy outlives the owner's last
+            // reference, so the merge happens first and the foreign thread
+            // runs the destruction.
+            SP< TestPtr, BiasedThreaded > bt4( new TestPtr( 89, 90 ) );
+            assert( 2 == TestPtr::total );
+            std::atomic< bool > copied( false );
+            std::atomic< bool > ownerDone( false );
+            std::thread holder( [ &bt4, &copied, &ownerDone ]()
+            {
+                SP< TestPtr, BiasedThreaded > foreign( bt4 );
+                copied.store( true );
+                while ( !ownerDone.load() )
+                {
+                    std::this_thread::yield();
+                }
+                assert( 89 == foreign->a );
+            } );
+            while ( !copied.load() )
+            {
+                std::this_thread::yield();
+            }
+            bt4.Delete();
+            ownerDone.store( true );
+            holder.join();
+            assert( 1 == TestPtr::total );
+
+            // A coalesced span release on the owner thread covering both
+            // owner-counted and foreign-counted copies of one object: only
+            // the owner's share comes out of the biased count, the rest
+            // goes through the atomic word, and the object dies exactly
+            // once.
+            std::vector< SP< TestPtr, BiasedThreaded > > mixed;
+            mixed.reserve( 3 );
+            mixed.push_back(
+                SP< TestPtr, BiasedThreaded >( new TestPtr( 95, 96 ) ) );
+            mixed.push_back( mixed[ 0 ] );
+            std::thread contributor( [ &mixed ]()
+            {
+                mixed.push_back( mixed[ 0 ] );
+            } );
+            contributor.join();
+            assert( 2 == TestPtr::total );
+            ReleaseSpan( mixed );
+            assert( mixed[ 0 ].IsNull() );
+            assert( 1 == TestPtr::total );
+        }
+
+        //************************* CowP Tests *****************************
+        // Copy-on-write: hand-outs and reads share the object; the first
+        // write while shared clones it, leaving the readers undisturbed.
+        {
+            CowP< TestPtr > cow1 = MakeCowP< TestPtr >( 91, 92 );
+            assert( !cow1.IsNull() );
+            assert( 91 == cow1->a );
+            assert( 2 == TestPtr::total );
+            assert( 1 == cow1.UseCount() );
+
+            // The sole owner writes in place - no clone.
+            cow1.Mutate()->a = 93;
+            assert( 93 == cow1->a );
+            assert( 2 == TestPtr::total );
+
+            // A hand-out is a count bump, not a copy.
+            CowP< TestPtr > cow2( cow1 );
+            assert( 2 == cow1.UseCount() );
+            assert( cow1 == cow2 );
+            assert( 2 == TestPtr::total );
+
+            // A write while shared clones, and the reader keeps the old
+            // version.
+            cow2.Mutate()->a = 94;
+            assert( 3 == TestPtr::total );
+            assert( 93 == cow1->a );
+            assert( 94 == cow2->a );
+            assert( cow1 != cow2 );
+            assert( 1 == cow1.UseCount() );
+            assert( 1 == cow2.UseCount() );
+
+            // Back to sole ownership, writes are in place again.
+            cow2.Mutate()->b = 95;
+            assert( 3 == TestPtr::total );
+            assert( 95 == cow2->b );
+
+            cow2.Delete();
+            assert( 2 == TestPtr::total );
+        }
+        assert( 1 == TestPtr::total );
+
+        //********************** Aliasing SP Tests *************************
+        // An aliasing SP shares the owner's count block but dereferences to
+        // a member, so handing out a member keeps the whole object alive
+        // without allocating a new control block.
+        {
+            SP< TestPtr > whole( new TestPtr( 61, 62 ) );
+            assert( 2 == TestPtr::total );
+
+            SP< int > part( whole, &whole->a );
+            assert( 61 == *part );
+
+            // Copies of the alias behave like any other SP.
+            SP< int > part2( part );
+            assert( 61 == *part2 );
+
+            // A WP made from the alias promotes back to the member.
+            WP< int > partWeak( part );
+
+            // The aliases keep the whole object alive after the original
+            // owner lets go...
+            whole.Delete();
+            assert( 2 == TestPtr::total );
+            assert( 61 == *part );
+
+            SP< int > promoted = partWeak.GetSP();
+            assert( !promoted.IsNull() );
+            assert( 61 == *promoted );
+            promoted.Delete();
+
+            // ...and the last alias out destroys it.
+            part.Delete();
+            part2.Delete();
+            assert( 1 == TestPtr::total );
+            assert( partWeak.IsNull() );
+            partWeak.Drop();
+
+            // A null owner yields a null alias.
+            SP< TestPtr > noOwner;
+            SP< int > noPart( noOwner, nullptr );
+            assert( noPart.IsNull() );
+        }
+
+        //********************* Intrusive SP Tests *************************
+        // Classes derived from RefCounted carry their own count, so the SP
+        // uses no separate control block; the object pointer IS the handle.
+        {
+            SP< TestIntrusive > in1( new TestIntrusive( 91 ) );
+            assert( !in1.IsNull() );
+            assert( 91 == in1->v );
+            assert( 1 == TestIntrusive::total );
+
+            // Copies bump the embedded count and share the same object.
+            SP< TestIntrusive > in2( in1 );
+            assert( in1.UnsafeAccess() == in2.UnsafeAccess() );
+            assert( 1 == TestIntrusive::total );
+
+            // The factory works for intrusive classes as well (a plain new,
+            // as there is no control block to fold in).
+            SP< TestIntrusive > in3 = MakeSP< TestIntrusive >( 92 );
+            assert( 92 == in3->v );
+            assert( 2 == TestIntrusive::total );
+
+            in3.Delete();
+            assert( 1 == TestIntrusive::total );
+            in1.Delete();
+            assert( 1 == TestIntrusive::total );
+            in2.Delete();
+            assert( 0 == TestIntrusive::total );
+        }
+
+        //****************** Deferred reclamation Tests ********************
+        // With deferral enabled, the last Delete only queues the teardown;
+        // the destructor runs when the drain is pumped.
+        {
+            DeferredReclaim::Enable();
+
+            SP< TestPtr > doomed( new TestPtr( 71, 72 ) );
+            WP< TestPtr > watch( doomed );
+            assert( 2 == TestPtr::total );
+
+            doomed.Delete();
+            // The destructor has NOT run yet - the object is queued...
+            assert( 2 == TestPtr::total );
+            // ...but it is already dead to the rest of the process.
+            assert( watch.Expired() );
+            assert( watch.GetSP().IsNull() );
+
+            // Pumping the drain runs the teardown.
+            assert( 1 == DrainDeferred() );
+            assert( 1 == TestPtr::total );
+            watch.Drop();
+
+            // Combined (MakeSP) allocations defer the same way.
+            SP< TestPtr > doomed2 = MakeSP< TestPtr >( 73, 74 );
+            doomed2.Delete();
+            assert( 2 == TestPtr::total );
+            assert( 1 == DrainDeferred() );
+            assert( 1 == TestPtr::total );
+
+            DeferredReclaim::Disable();
+            assert( 0 == DrainDeferred() );
+
+            // With deferral off, teardown is inline again.
+            SP< TestPtr > inlineDel( new TestPtr( 75, 76 ) );
+            inlineDel.Delete();
+            assert( 1 == TestPtr::total );
+        }
+
+        //******************** Epoch reclamation Tests *********************
+        // With epoch mode on, deletes wait for readers: a TP held inside a
+        // ReadGuard stays dereferenceable even after the owner deletes.
+        {
+            EpochReclaim::Enable();
+
+            UP< TestPtr > owner = MakeUP< TestPtr >( 77, 78 );
+            TP< TestPtr > reader( owner );
+            {
+                ReadGuard guard;
+
+                owner.Delete();
+                // The destructor has not run; the guard pins the epoch...
+                assert( 2 == TestPtr::total );
+                assert( 77 == reader->a );
+
+                // ...and even an explicit collection cannot free it.
+                EpochReclaim::Collect();
+                assert( 2 == TestPtr::total );
+                assert( 78 == reader->b );
+            }
+
+            // Guard released: collection reclaims the object.
+            assert( 1 == EpochReclaim::Collect() );
+            assert( 1 == TestPtr::total );
+            reader.Release();
+
+            // The SP paths defer the same way, including the combined
+            // (MakeSP) layout where the object shares its control block's
+            // memory.
+            SP< TestPtr > shared = MakeSP< TestPtr >( 79, 80 );
+            TP< TestPtr > sharedReader( shared );
+            {
+                ReadGuard guard;
+
+                shared.Delete();
+                assert( 2 == TestPtr::total );
+                assert( 79 == sharedReader->a );
+            }
+            // Both the destructor and the block free were retired.
+            assert( 2 == EpochReclaim::Collect() );
+            assert( 1 == TestPtr::total );
+            sharedReader.Release();
+
+            EpochReclaim::Disable();
+
+            // Back to inline deletes.
+            UP< TestPtr > plain = MakeUP< TestPtr >( 81, 82 );
+            plain.Delete();
+            assert( 1 == TestPtr::total );
+        }
+
+        //******************** Arena / deleter Tests ***********************
+        // A NoDelete UP owns semantically but never issues a delete.
+        {
+            TestPtr* raw = new TestPtr( 85, 86 );
+            {
+                UP< TestPtr, NoDelete > noDel( raw );
+                assert( 85 == noDel->a );
+                assert( 2 == TestPtr::total );
+            }
+            // The UP went out of scope without destroying the object.
+            assert( 2 == TestPtr::total );
+            delete raw;
+            assert( 1 == TestPtr::total );
+        }
+
+        // Arena-backed allocation: bump-allocated objects, released in one
+        // motion by Reset.
+        {
+            Arena arena( 1024 );
+
+            int* one = arena.Make< int >( 5 );
+            assert( 5 == *one );
+
+            double* two = arena.Make< double >( 2.5 );
+            assert( 2.5 == *two );
+            assert( 0 == ( reinterpret_cast< std::uintptr_t >( two )
+                           % alignof( double ) ) );
+
+            // Spill across several chunks.
+            int* last = nullptr;
+            for ( int i = 0; i < 1000; ++i )
+            {
+                last = arena.Make< int >( i );
+            }
+            assert( 999 == *last );
+
+            // Owning-pointer semantics without per-object deletes.
+            UP< TestArenaObj, NoDelete > obj =
+                arena.MakeUP< TestArenaObj >( 7, 9 );
+            assert( 7 == obj->a );
+            TP< TestArenaObj > peek( obj );
+            assert( 9 == peek->b );
+            obj.Delete();  // A no-op on the storage; the arena owns it.
+
+            // Reset recycles the region; the arena is immediately usable.
+            arena.Reset();
+            int* again = arena.Make< int >( 42 );
+            assert( 42 == *again );
+        }
+
+        //******************* Threaded refcount Tests **********************
+        // Hammer the (lock-free) reference counts from several threads at
+        // once.  With the counts correct, exactly one TestPtr remains after
+        // all the copies die, and it goes away when the original does.
+        TestPtr::output = false;
+        {
+            SP< TestPtr > shared( new TestPtr( 99, 100 ) );
+            WP< TestPtr > weak( shared );
+
+            constexpr int threads = 8;
+            constexpr int copies_per_thread = 100000;
+
+            std::vector< std::thread > workers;
+            for ( int t = 0; t < threads; ++t )
+            {
+                workers.push_back( std::thread( [ &shared, &weak ]()
+                {
+                    for ( int i = 0; i < copies_per_thread; ++i )
+                    {
+                        SP< TestPtr > localCopy( shared );
+                        SP< TestPtr > promoted = weak.GetSP();
+                        WP< TestPtr > localWeak( localCopy );
+                    }
+                } ) );
+            }
+            for ( auto& w : workers )
+            {
+                w.join();
+            }
+
+            // All the copies are gone; just the original remains.
+            assert( !shared.IsNull() );
+            assert( 99 == shared->a );
+            assert( 2 == TestPtr::total );
+        }
+
+        // Race weak promotion against the final DecRef.  Promotion either
+        // claims a reference (and the object is then fully alive to read)
+        // or yields a null SP; it must never resurrect a dying object.
+        {
+            constexpr int race_iters = 2000;
+            for ( int i = 0; i < race_iters; ++i )
+            {
+                SP< TestPtr > owner( new TestPtr( 55, 56 ) );
+                WP< TestPtr > weak( owner );
+
+                std::thread promoter( [ &weak ]()
+                {
+                    for ( ;; )
+                    {
+                        SP< TestPtr > promoted = weak.GetSP();
+                        if ( promoted.IsNull() )
+                        {
+                            break;
+                        }
+                        assert( 55 == promoted->a );
+                    }
+                } );
+
+                owner.Delete();
+                promoter.join();
+                weak.Drop();
+            }
+            assert( 1 == TestPtr::total );
+        }
+        TestPtr::output = true;
+
+        //********************** Bulk span Tests ***************************
+        // CopySpan/ReleaseSpan coalesce runs of SPs sharing a count block
+        // into one count update; the reference accounting must come out
+        // identical to element-by-element copies and releases.
+        TestPtr::output = false;
+        {
+            // A snapshot with repeated blocks (adjacent copies) and a null.
+            std::vector< SP< TestPtr > > src;
+            SP< TestPtr > first = MakeSP< TestPtr >( 1, 1 );
+            SP< TestPtr > second = MakeSP< TestPtr >( 2, 2 );
+            src.push_back( first );
+            src.push_back( first );
+            src.push_back( second );
+            src.push_back( SP< TestPtr >() );
+            src.push_back( second );
+
+            std::vector< SP< TestPtr > > dst;
+            CopySpan( dst, src );
+            assert( dst.size() == src.size() );
+            assert( 1 == dst[ 0 ]->a );
+            assert( dst[ 1 ].UnsafeAccess() == first.UnsafeAccess() );
+            assert( dst[ 3 ].IsNull() );
+            assert( 2 == dst[ 4 ]->a );
+
+            // Releasing the source leaves the copies owning.
+            ReleaseSpan( src );
+            assert( src[ 0 ].IsNull() );
+            assert( src[ 2 ].IsNull() );
+            assert( 1 == dst[ 0 ]->a );
+
+            first.Delete();
+            second.Delete();
+            assert( 3 == TestPtr::total );   // dst alone keeps both alive.
+            ReleaseSpan( dst );
+            assert( 1 == TestPtr::total );
+
+            // Copying over a destination that already owns releases what
+            // it held - including slots beyond the source's length.
+            std::vector< SP< TestPtr > > held( 4, MakeSP< TestPtr >( 5, 5 ) );
+            std::vector< SP< TestPtr > > tiny;
+            tiny.push_back( MakeSP< TestPtr >( 6, 6 ) );
+            CopySpan( held, tiny );
+            assert( 1 == held.size() );
+            assert( 6 == held[ 0 ]->a );
+            assert( 2 == TestPtr::total );   // The 5s are gone.
+            ReleaseSpan( held );
+            ReleaseSpan( tiny );
+            assert( 1 == TestPtr::total );
+        }
+        TestPtr::output = true;
+
+        //********************** Array UP/SP Tests *************************
+        // UP< T[] > and SP< T[] > manage new[] buffers with delete[]
+        // semantics and operator[] access.
+        {
+            // One allocation, value-initialized elements.
+            UP< int[] > buffer = MakeUP< int[] >( 16 );
+            assert( !buffer.IsNull() );
+            assert( 0 == buffer[ 7 ] );
+            buffer[ 0 ] = 1;
+            buffer[ 15 ] = 99;
+            assert( 99 == buffer[ 15 ] );
+
+            // delete[] runs every element's destructor.
+            {
+                UP< TestArrayObj[] > objs = MakeUP< TestArrayObj[] >( 3 );
+                assert( 3 == TestArrayObj::constructs );
+                objs[ 1 ].m_value = 5;
+            }
+            assert( 3 == TestArrayObj::destructs );
+
+            // Shared buffers: the last reference out deletes.
+            SP< int[] > shared( new int[ 8 ]() );
+            shared[ 2 ] = 5;
+            {
+                SP< int[] > copy( shared );
+                assert( 2 == copy.UseCount() );
+                assert( 5 == copy[ 2 ] );
+            }
+            assert( 1 == shared.UseCount() );
+
+            // A UP< T[] > transfers into shared management, and copies
+            // keep the buffer alive after the original lets go.
+            {
+                UP< TestArrayObj[] > from = MakeUP< TestArrayObj[] >( 2 );
+                SP< TestArrayObj[] > sharedObjs( std::move( from ) );
+                assert( from.IsNull() );
+                SP< TestArrayObj[] > keeper = sharedObjs;
+                sharedObjs.Delete();
+                assert( !keeper.IsNull() );
+                assert( 0 == keeper[ 0 ].m_value );
+            }
+            assert( TestArrayObj::destructs == TestArrayObj::constructs );
+
+            // MemCache's array operators: the whole array block cycles
+            // through the class's cache.
+            TestCached* cachedArr = new TestCached[ 2 ]{ 1, 2 };
+            assert( 2 == cachedArr[ 1 ].v );
+            delete[] cachedArr;
+        }
+
+        //************************* Span Tests *****************************
+        // Non-owning views over contiguous ranges: construction from the
+        // usual sources, element access, iteration, and the comparison
+        // families.
+        {
+            int raw[ 5 ] = { 1, 2, 3, 4, 5 };
+            Span< int > view( raw );
+            assert( 5 == view.Size() );
+            assert( !view.IsEmpty() );
+            assert( raw == view.Data() );
+            assert( 3 == view[ 2 ] );
+
+            // Iteration is a raw pointer walk.
+            int sum = 0;
+            for ( int v : view )
+            {
+                sum += v;
+            }
+            assert( 15 == sum );
+
+            // Vector views write through, like the vector's own iterators.
+            std::vector< int > vec = { 10, 20, 30, 40 };
+            Span< int > vecView( vec );
+            assert( 4 == vecView.Size() );
+            vecView[ 1 ] = 21;
+            assert( 21 == vec[ 1 ] );
+
+            Span< int > mid = vecView.SubSpan( 1, 2 );
+            assert( 2 == mid.Size() );
+            assert( 21 == mid[ 0 ] );
+            assert( vecView.SubSpan( 9, 1 ).IsEmpty() );
+            assert( 1 == vecView.SubSpan( 3, 5 ).Size() );   // Clamped.
+
+            // Read-only views come from mutable views and const vectors.
+            Span< const int > readView( vecView );
+            assert( 30 == readView[ 2 ] );
+            const std::vector< int >& constVec = vec;
+            Span< const int > constView( constVec );
+            assert( 4 == constView.Size() );
+
+            // Identity comparisons, and the TP cross-type family.
+            Span< int > same( vec );
+            assert( same == vecView );
+            assert( mid != vecView );
+            TP< int > first( &raw[ 0 ] );
+            TP< int > second( &raw[ 1 ] );
+            assert( view == first );
+            assert( first == view );
+            assert( view != second );
+            assert( view < second );
+
+            view.Release();
+            assert( view.IsEmpty() );
+        }
+
+        //********************* ObjectPool Tests ***************************
+        // Recycling keeps objects constructed: a release Resets and pools,
+        // and the next Acquire pops instead of constructing.
+        {
+            ObjectPool< TestPooled > pool;
+
+            // Pre-warm; the reserve also floors the trimming below.
+            pool.Reserve( 2 );
+            assert( 2 == TestPooled::constructs );
+            assert( 2 == pool.Cached() );
+
+            {
+                ObjectPool< TestPooled >::Handle h = pool.Acquire();
+                assert( 2 == TestPooled::constructs );   // Recycled, not built.
+                assert( 1 == pool.InUse() );
+                assert( 1 == pool.Cached() );
+                h->m_state = 42;
+            }
+            // The release Reset the object and pooled it; nothing died.
+            assert( 1 == TestPooled::resets );
+            assert( 0 == TestPooled::destructs );
+            assert( 0 == pool.InUse() );
+            assert( 2 == pool.Cached() );
+
+            // The recycled object comes back in its Reset state.
+            {
+                ObjectPool< TestPooled >::Handle h = pool.Acquire();
+                assert( 0 == h->m_state );
+            }
+
+            // Draining the pool forces fresh construction.
+            {
+                ObjectPool< TestPooled >::Handle a = pool.Acquire();
+                ObjectPool< TestPooled >::Handle b = pool.Acquire();
+                ObjectPool< TestPooled >::Handle c = pool.Acquire();
+                assert( 3 == TestPooled::constructs );
+                assert( 3 == pool.InUse() );
+            }
+            // All three fit back: the reserve floor is 2, but in-use
+            // dropped gradually, and the floor keeps at least 2; the
+            // trim deletes the excess above the floor.
+            assert( 2 == pool.Cached() );
+            assert( 1 == TestPooled::destructs );
+        }
+        // The pool's destructor destroyed the remaining cached objects.
+        assert( TestPooled::destructs == TestPooled::constructs );
+
+        //*********************** PtrQueue Tests ***************************
+        // Single-threaded sanity first: ordering, full, and empty.
+        TestPtr::output = false;
+        {
+            PtrQueue< TestPtr > queue( 4 );
+            UP< TestPtr > out;
+
+            assert( !queue.Pop( out ) );                 // Empty.
+
+            for ( int i = 0; i < 4; ++i )
+            {
+                assert( queue.Push( MakeUP< TestPtr >( i, i ) ) );
+            }
+
+            // Full: the push fails and the caller keeps ownership.
+            UP< TestPtr > keeper = MakeUP< TestPtr >( 9, 9 );
+            assert( !queue.Push( std::move( keeper ) ) );
+            assert( !keeper.IsNull() );
+
+            for ( int i = 0; i < 4; ++i )
+            {
+                assert( queue.Pop( out ) );
+                assert( i == out->a );                   // FIFO order.
+            }
+            assert( !queue.Pop( out ) );
+        }
+
+        // A queue destroyed with objects still in flight deletes them.
+        {
+            PtrQueue< TestPtr > queue( 4 );
+            queue.Push( MakeUP< TestPtr >( 1, 1 ) );
+            queue.Push( MakeUP< TestPtr >( 2, 2 ) );
+        }
+        assert( 1 == TestPtr::total );
+
+        // SPSC handoff across threads: every object the producer sends
+        // arrives exactly once, in order.
+        {
+            constexpr int handoffs = 100000;
+            PtrQueue< TestPtr > queue( 64 );
+
+            std::thread producer( [ &queue ]()
+            {
+                for ( int i = 0; i < handoffs; ++i )
+                {
+                    UP< TestPtr > item = MakeUP< TestPtr >( i, i );
+                    while ( !queue.Push( std::move( item ) ) )
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            } );
+
+            int received = 0;
+            UP< TestPtr > item;
+            while ( received < handoffs )
+            {
+                if ( queue.Pop( item ) )
+                {
+                    assert( received == item->a );
+                    ++received;
+                }
+            }
+
+            producer.join();
+            item.Delete();
+            assert( 1 == TestPtr::total );
+        }
+
+        // MPMC: several producers and consumers; every object arrives
+        // exactly once (the sum of received payloads proves it).
+        {
+            constexpr int producers = 4;
+            constexpr int consumers = 4;
+            constexpr int per_producer = 25000;
+
+            PtrQueue< TestPtr, MultiProducerMultiConsumer > queue( 64 );
+            std::atomic< long long > receivedSum( 0 );
+            std::atomic< int > receivedCount( 0 );
+
+            std::vector< std::thread > workers;
+            for ( int t = 0; t < producers; ++t )
+            {
+                workers.push_back( std::thread( [ &queue, t ]()
+                {
+                    for ( int i = 0; i < per_producer; ++i )
+                    {
+                        UP< TestPtr > item =
+                            MakeUP< TestPtr >( t * per_producer + i, 0 );
+                        while ( !queue.Push( std::move( item ) ) )
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                } ) );
+            }
+            for ( int t = 0; t < consumers; ++t )
+            {
+                workers.push_back( std::thread(
+                    [ &queue, &receivedSum, &receivedCount ]()
+                {
+                    UP< TestPtr > item;
+                    while ( receivedCount.load() < producers * per_producer )
+                    {
+                        if ( queue.Pop( item ) )
+                        {
+                            receivedSum += item->a;
+                            ++receivedCount;
+                        }
+                    }
+                } ) );
+            }
+            for ( auto& w : workers )
+            {
+                w.join();
+            }
+
+            constexpr long long total = producers * per_producer;
+            assert( total == receivedCount.load() );
+            assert( ( total * ( total - 1 ) / 2 ) == receivedSum.load() );
+            assert( 1 == TestPtr::total );
+        }
+        TestPtr::output = true;
+
+#ifdef WBS_PTR_PROFILE
+        //******************** PtrProfile Tests ****************************
+        // Only compiled into profiling builds, like the hooks themselves.
+        TestPtr::output = false;
+        {
+            // A raw-pointer adoption shows up under this file and line.
+            const int adoptLine = __LINE__ + 1;
+            UP< TestPtr > tracked( new TestPtr( 7, 8 ) );
+
+            bool found = false;
+            for ( const PtrProfile::SiteInfo& row : PtrProfile::Snapshot() )
+            {
+                if ( adoptLine == row.m_line )
+                {
+                    assert( 1 <= row.m_allocs );
+                    assert( 1 <= row.m_live );
+                    assert( 1 <= row.m_highWater );
+                    found = true;
+                }
+            }
+            assert( found );
+
+            // Releasing it drives the site's live count back down.
+            tracked.Delete();
+            for ( const PtrProfile::SiteInfo& row : PtrProfile::Snapshot() )
+            {
+                if ( adoptLine == row.m_line )
+                {
+                    assert( row.m_frees == row.m_allocs );
+                    assert( 0 == row.m_live );
+                }
+            }
+
+            // A Scope re-attributes factory adoptions (MakeSP adopts from
+            // inside SP.h) to the scope's own site.
+            const int scopeLine = __LINE__ + 2;
+            {
+                PtrProfile::Scope scope;
+                SP< TestPtr > shared = MakeSP< TestPtr >( 9, 10 );
+            }
+            found = false;
+            for ( const PtrProfile::SiteInfo& row : PtrProfile::Snapshot() )
+            {
+                if ( scopeLine == row.m_line )
+                {
+                    assert( 1 <= row.m_allocs );
+                    assert( row.m_frees == row.m_allocs );
+                    assert( 0 == row.m_live );
+                    found = true;
+                }
+            }
+            assert( found );
+        }
+        TestPtr::output = true;
+#endif // #ifdef WBS_PTR_PROFILE
+
+#ifdef WBS_TP_VALIDATE
+        //******************* TP validation Tests **************************
+        // Only compiled into validation builds, like the hooks themselves.
+        TestPtr::output = false;
+        {
+            // A TP watching a live owned object dereferences cleanly.
+            UP< TestPtr > owner = MakeUP< TestPtr >( 96, 97 );
+            TP< TestPtr > watcher( owner );
+            assert( 96 == watcher->a );
+
+            const void* addr = owner.UnsafeAccess();
+            std::uint64_t gen = TPValidate::Capture( addr );
+            assert( 0 != gen );
+            assert( TPValidate::Valid( addr, gen ) );
+
+            // Destroying the object retires its stamp: the captured
+            // generation no longer validates (the watcher's next
+            // dereference would assert).
+            owner.Delete();
+            assert( !TPValidate::Valid( addr, gen ) );
+            assert( 0 == TPValidate::Capture( addr ) );
+
+            // A new object gets a NEW generation, so even reuse of the
+            // same address cannot revalidate the old stamp.
+            UP< TestPtr > next( new TestPtr( 98, 99 ) );
+            assert( !TPValidate::Valid( addr, gen ) );
+            next.Delete();
+
+            // SP-owned objects are stamped too, in both modes.
+            SP< TestPtr > shared = MakeSP< TestPtr >( 11, 12 );
+            TP< TestPtr > sharedWatcher( shared );
+            assert( 11 == sharedWatcher->a );
+            assert( 0 != TPValidate::Capture( shared.UnsafeAccess() ) );
+            shared.Delete();
+
+            // Objects no owner ever stamped (a stack object here) capture
+            // generation zero and dereference unchecked - no false alarms
+            // from adopting TPs incrementally.
+            TestPtr local( 1, 2 );
+            TP< TestPtr > raw( &local );
+            assert( 1 == raw->a );
+        }
+        TestPtr::output = true;
+#endif // #ifdef WBS_TP_VALIDATE
+
     } // End of inner block, causing all pointers to go out of scope.
 
 